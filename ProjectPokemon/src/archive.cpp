@@ -0,0 +1,533 @@
+#include "archive.h"
+
+#ifdef _WIN32
+#	define WIN32_LEAN_AND_MEAN
+#	define NOMINMAX
+#	include <windows.h>
+#else
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif
+
+namespace
+{
+	constexpr Size lz_min_match = 4;
+	constexpr Size lz_max_offset = 0xFFFF;
+	constexpr Size lz_hash_bits = 14;
+	constexpr Size lz_run_mask = 0xF;
+
+	inline UInt32 lz_read32(const Byte* ptr)
+	{
+		UInt32 value;
+		std::memcpy(&value, ptr, sizeof(value));
+		return value;
+	}
+
+	inline Size lz_slot(UInt32 sequence) { return (sequence * 2654435761U) >> (32 - lz_hash_bits); }
+
+	inline void lz_write_length(std::vector<Byte>& output, Size length)
+	{
+		for (; length >= 0xFF; length -= 0xFF)
+			output.push_back(Byte{ 0xFF });
+		output.push_back(static_cast<Byte>(length));
+	}
+
+	inline bool lz_read_length(std::span<const Byte> source, Size& position, Size& length)
+	{
+		for (;;)
+		{
+			if (position >= source.size())
+				return false;
+
+			Size value = static_cast<UInt8>(source[position++]);
+			length += value;
+			if (value != 0xFF)
+				return true;
+		}
+	}
+
+	/* A match length of zero marks the trailing literals-only sequence */
+	void lz_emit(std::vector<Byte>& output, std::span<const Byte> literals, Size matchLength, Size matchOffset)
+	{
+		Size literalCount = literals.size();
+		Size matchCode = matchLength ? matchLength - lz_min_match : 0;
+
+		output.push_back(static_cast<Byte>((std::min(literalCount, lz_run_mask) << 4) | std::min(matchCode, lz_run_mask)));
+		if (literalCount >= lz_run_mask)
+			lz_write_length(output, literalCount - lz_run_mask);
+		output.insert(output.end(), literals.begin(), literals.end());
+
+		if (matchLength)
+		{
+			output.push_back(static_cast<Byte>(matchOffset & 0xFF));
+			output.push_back(static_cast<Byte>(matchOffset >> 8));
+			if (matchCode >= lz_run_mask)
+				lz_write_length(output, matchCode - lz_run_mask);
+		}
+	}
+
+	constexpr UInt64 align_up(UInt64 value, UInt64 alignment) { return (value + alignment - 1) & ~(alignment - 1); }
+
+	constexpr std::array<std::string_view, 7> raw_extensions = { ".ttf", ".otf", ".ttc", ".pfb", ".pfm", ".pcf", ".fnt" };
+}
+
+void utils::lz_compress(std::span<const Byte> source, std::vector<Byte>& output)
+{
+	output.clear();
+	output.reserve(source.size() + source.size() / 255 + 16);
+
+	std::vector<UInt32> table(Size(1) << lz_hash_bits, 0);
+	const Byte* data = source.data();
+	Size size = source.size();
+	Size anchor = 0;
+	Size position = 0;
+
+	while (position + lz_min_match <= size)
+	{
+		UInt32 sequence = lz_read32(data + position);
+		UInt32& slot = table[lz_slot(sequence)];
+		Size candidate = slot;
+		slot = static_cast<UInt32>(position + 1);
+
+		if (candidate == 0 || position - (candidate - 1) > lz_max_offset || lz_read32(data + candidate - 1) != sequence)
+		{
+			++position;
+			continue;
+		}
+
+		Size match = candidate - 1;
+		Size length = lz_min_match;
+		while (position + length < size && data[match + length] == data[position + length])
+			++length;
+
+		lz_emit(output, source.subspan(anchor, position - anchor), length, position - match);
+		position += length;
+		anchor = position;
+	}
+
+	lz_emit(output, source.subspan(anchor), 0, 0);
+}
+
+bool utils::lz_decompress(std::span<const Byte> source, std::span<Byte> output)
+{
+	Size in = 0;
+	Size out = 0;
+
+	while (in < source.size())
+	{
+		UInt8 token = static_cast<UInt8>(source[in++]);
+
+		Size literalCount = token >> 4;
+		if (literalCount == lz_run_mask && !lz_read_length(source, in, literalCount))
+			return false;
+		if (literalCount > source.size() - in || literalCount > output.size() - out)
+			return false;
+
+		std::memcpy(output.data() + out, source.data() + in, literalCount);
+		in += literalCount;
+		out += literalCount;
+
+		if (in == source.size())
+			break;
+
+		if (source.size() - in < 2)
+			return false;
+
+		Size offset = static_cast<UInt8>(source[in]) | (Size(static_cast<UInt8>(source[in + 1])) << 8);
+		in += 2;
+		if (offset == 0 || offset > out)
+			return false;
+
+		Size length = token & lz_run_mask;
+		if (length == lz_run_mask && !lz_read_length(source, in, length))
+			return false;
+		length += lz_min_match;
+		if (length > output.size() - out)
+			return false;
+
+		/* Matches may overlap their own output, so copy forward one byte at a time */
+		for (Size i = 0; i < length; ++i, ++out)
+			output[out] = output[out - offset];
+	}
+
+	return out == output.size();
+}
+
+
+
+MappedFile::MappedFile(MappedFile&& other) noexcept :
+	_data{ std::exchange(other._data, nullptr) },
+	_size{ std::exchange(other._size, 0) }
+{}
+
+MappedFile::~MappedFile() { close(); }
+
+MappedFile& MappedFile::operator= (MappedFile&& right) noexcept
+{
+	if (this != &right)
+	{
+		close();
+		_data = std::exchange(right._data, nullptr);
+		_size = std::exchange(right._size, 0);
+	}
+	return *this;
+}
+
+bool MappedFile::open(const Path& path)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	/* The view keeps the mapping and the file alive on its own */
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (!mapping)
+		return false;
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (!view)
+		return false;
+
+	_data = static_cast<const Byte*>(view);
+	_size = static_cast<Size>(size.QuadPart);
+#else
+	int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return false;
+
+	struct stat info;
+	if (::fstat(fd, &info) != 0 || info.st_size <= 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	void* view = ::mmap(nullptr, static_cast<Size>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (view == MAP_FAILED)
+		return false;
+
+	_data = static_cast<const Byte*>(view);
+	_size = static_cast<Size>(info.st_size);
+#endif
+
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (!_data)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(_data);
+#else
+	::munmap(const_cast<Byte*>(_data), _size);
+#endif
+
+	_data = nullptr;
+	_size = 0;
+}
+
+
+
+MemoryStreamBuffer::MemoryStreamBuffer(std::span<const Byte> bytes)
+{
+	char* begin = const_cast<char*>(reinterpret_cast<const char*>(bytes.data()));
+	setg(begin, begin, begin + bytes.size());
+}
+
+MemoryStreamBuffer::pos_type MemoryStreamBuffer::seekoff(off_type offset, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+	if (!(which & std::ios_base::in))
+		return pos_type(off_type(-1));
+
+	off_type position = offset;
+	if (dir == std::ios_base::cur)
+		position += gptr() - eback();
+	else if (dir == std::ios_base::end)
+		position += egptr() - eback();
+
+	if (position < 0 || position > egptr() - eback())
+		return pos_type(off_type(-1));
+
+	setg(eback(), eback() + position, egptr());
+	return pos_type(position);
+}
+
+MemoryStreamBuffer::pos_type MemoryStreamBuffer::seekpos(pos_type position, std::ios_base::openmode which)
+{
+	return seekoff(off_type(position), std::ios_base::beg, which);
+}
+
+
+
+bool Archive::open(const Path& path)
+{
+	close();
+	if (!_file.open(path))
+		return false;
+
+	std::span<const Byte> bytes = _file.bytes();
+	if (bytes.size() < sizeof(ArchiveHeader))
+		return close(), false;
+
+	const ArchiveHeader* header = reinterpret_cast<const ArchiveHeader*>(bytes.data());
+	if (header->magic != ArchiveHeader::magic_value || header->version != ArchiveHeader::current_version || !std::has_single_bit(header->alignment))
+		return close(), false;
+
+	if (header->indexOffset % alignof(ArchiveEntry) != 0 || header->indexOffset > bytes.size() ||
+		header->entryCount > (bytes.size() - header->indexOffset) / sizeof(ArchiveEntry) ||
+		header->namesOffset > bytes.size() || header->namesSize > bytes.size() - header->namesOffset)
+		return close(), false;
+
+	std::span<const ArchiveEntry> entries{ reinterpret_cast<const ArchiveEntry*>(bytes.data() + header->indexOffset), header->entryCount };
+	for (Size i = 0; i < entries.size(); ++i)
+	{
+		const ArchiveEntry& entry = entries[i];
+		if (entry.offset > bytes.size() || entry.size > bytes.size() - entry.offset ||
+			UInt64(entry.nameOffset) + entry.nameLength > header->namesSize ||
+			(!entry.isCompressed() && entry.size != entry.rawSize) ||
+			(i > 0 && entries[i - 1].hash > entry.hash))
+			return close(), false;
+	}
+
+	_header = header;
+	_entries = entries;
+	_names = { reinterpret_cast<const char*>(bytes.data() + header->namesOffset), static_cast<Size>(header->namesSize) };
+	_path = path;
+	return true;
+}
+
+void Archive::close()
+{
+	_file.close();
+	_path.clear();
+	_header = nullptr;
+	_entries = {};
+	_names = {};
+}
+
+const ArchiveEntry* Archive::find(std::string_view name) const
+{
+	UInt64 hash = hashOf(name);
+	auto it = std::ranges::lower_bound(_entries, hash, {}, &ArchiveEntry::hash);
+	for (; it != _entries.end() && it->hash == hash; ++it)
+		if (nameOf(*it) == name)
+			return std::to_address(it);
+	return nullptr;
+}
+
+bool Archive::read(const ArchiveEntry& entry, std::span<Byte> output) const
+{
+	if (output.size() != entry.rawSize)
+		return false;
+
+	std::span<const Byte> stored = view(entry);
+	if (entry.isCompressed())
+		return utils::lz_decompress(stored, output);
+
+	std::memcpy(output.data(), stored.data(), stored.size());
+	return true;
+}
+
+bool Archive::read(const ArchiveEntry& entry, std::pmr::vector<Byte>& bytes) const
+{
+	bytes.resize(static_cast<Size>(entry.rawSize));
+	return read(entry, std::span<Byte>{ bytes });
+}
+
+bool Archive::read(const ArchiveEntry& entry, std::pmr::string& text) const
+{
+	text.resize(static_cast<Size>(entry.rawSize));
+	return read(entry, std::span<Byte>{ reinterpret_cast<Byte*>(text.data()), text.size() });
+}
+
+
+
+ArchiveWriter::ArchiveWriter(UInt32 alignment) :
+	_alignment{ std::bit_ceil(std::max<UInt32>(alignment, alignof(ArchiveEntry))) }
+{}
+
+bool ArchiveWriter::add(const Path& name, std::span<const Byte> data, bool compress)
+{
+	String key = Archive::nameOf(name);
+	if (key.empty() || _names.contains(key))
+		return false;
+
+	compress = compress && !mustStoreRaw(name);
+
+	UInt64 contentHash = utils::fnv1a(data);
+	Size blob = _blobs.size();
+
+	auto it = _contents.find(contentHash);
+	if (it != _contents.end() && (compress || !_blobs[it->second].compressed) && _matches(_blobs[it->second], data))
+		blob = it->second;
+	else
+	{
+		Blob& added = _blobs.emplace_back(Blob{ {}, contentHash, data.size(), false });
+		if (compress && data.size() >= min_compress_size)
+		{
+			utils::lz_compress(data, added.data);
+			added.compressed = added.data.size() < data.size() - data.size() / 8;
+		}
+		if (!added.compressed)
+			added.data.assign(data.begin(), data.end());
+
+		if (it == _contents.end())
+			_contents.emplace(contentHash, blob);
+	}
+
+	UInt64 hash = Archive::hashOf(key);
+	_names.emplace(key, _items.size());
+	_items.push_back({ std::move(key), hash, blob });
+	return true;
+}
+
+bool ArchiveWriter::mustStoreRaw(const Path& name)
+{
+	String extension = name.extension().string();
+	std::ranges::transform(extension, extension.begin(), [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+	return std::ranges::find(raw_extensions, extension) != raw_extensions.end();
+}
+
+bool ArchiveWriter::addFile(const Path& name, const Path& file, bool compress)
+{
+	std::ifstream stream{ file, std::ios::in | std::ios::binary | std::ios::ate };
+	if (stream.fail())
+		return false;
+
+	std::vector<Byte> data(static_cast<Size>(stream.tellg()));
+	stream.seekg(0);
+	if (!stream.read(reinterpret_cast<char*>(data.data()), data.size()))
+		return false;
+
+	return add(name, data, compress);
+}
+
+Size ArchiveWriter::addDirectory(const Path& directory, bool compress)
+{
+	std::vector<Path> files;
+	for (const auto& entry : filesystem::recursive_directory_iterator{ directory })
+		if (entry.is_regular_file())
+			files.push_back(entry.path());
+
+	/* Sorted so the same directory always produces the same archive */
+	std::ranges::sort(files);
+
+	Size count = 0;
+	for (const Path& file : files)
+		count += addFile(file.lexically_relative(directory), file, compress);
+	return count;
+}
+
+bool ArchiveWriter::write(const Path& path) const
+{
+	std::vector<const Item*> order;
+	order.reserve(_items.size());
+	for (const Item& item : _items)
+		order.push_back(&item);
+	std::ranges::sort(order, [](const Item* left, const Item* right) { return left->hash != right->hash ? left->hash < right->hash : left->name < right->name; });
+
+	std::vector<UInt64> offsets(_blobs.size());
+	UInt64 offset = sizeof(ArchiveHeader);
+	for (Size i = 0; i < _blobs.size(); ++i)
+	{
+		offsets[i] = offset = align_up(offset, _alignment);
+		offset += _blobs[i].data.size();
+	}
+
+	ArchiveHeader header{};
+	header.magic = ArchiveHeader::magic_value;
+	header.version = ArchiveHeader::current_version;
+	header.entryCount = static_cast<UInt32>(order.size());
+	header.alignment = _alignment;
+	header.indexOffset = align_up(offset, alignof(ArchiveEntry));
+	header.namesOffset = header.indexOffset + order.size() * sizeof(ArchiveEntry);
+
+	std::vector<ArchiveEntry> index;
+	index.reserve(order.size());
+	String names;
+	for (const Item* item : order)
+	{
+		const Blob& blob = _blobs[item->blob];
+		if (names.size() + item->name.size() > std::numeric_limits<UInt32>::max())
+			return false;
+
+		ArchiveEntry& entry = index.emplace_back();
+		entry.hash = item->hash;
+		entry.offset = offsets[item->blob];
+		entry.size = blob.data.size();
+		entry.rawSize = blob.rawSize;
+		entry.nameOffset = static_cast<UInt32>(names.size());
+		entry.nameLength = static_cast<UInt32>(item->name.size());
+		entry.flags = blob.compressed ? ArchiveEntry::compressed : 0;
+		names += item->name;
+	}
+	header.namesSize = names.size();
+
+	std::ofstream stream{ path, std::ios::out | std::ios::binary | std::ios::trunc };
+	if (stream.fail())
+		return false;
+
+	static constexpr char padding[64] = {};
+	auto pad = [&stream](UInt64 from, UInt64 to) {
+		for (; from < to; from += std::min<UInt64>(to - from, sizeof(padding)))
+			stream.write(padding, static_cast<std::streamsize>(std::min<UInt64>(to - from, sizeof(padding))));
+	};
+
+	stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	offset = sizeof(header);
+	for (Size i = 0; i < _blobs.size(); ++i)
+	{
+		pad(offset, offsets[i]);
+		stream.write(reinterpret_cast<const char*>(_blobs[i].data.data()), static_cast<std::streamsize>(_blobs[i].data.size()));
+		offset = offsets[i] + _blobs[i].data.size();
+	}
+	pad(offset, header.indexOffset);
+	stream.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size() * sizeof(ArchiveEntry)));
+	stream.write(names.data(), static_cast<std::streamsize>(names.size()));
+
+	return stream.flush(), !stream.fail();
+}
+
+Size ArchiveWriter::storedBytes() const
+{
+	Size bytes = 0;
+	for (const Blob& blob : _blobs)
+		bytes += blob.data.size();
+	return bytes;
+}
+
+void ArchiveWriter::clear()
+{
+	_blobs.clear();
+	_items.clear();
+	_names.clear();
+	_contents.clear();
+}
+
+bool ArchiveWriter::_matches(const Blob& blob, std::span<const Byte> data)
+{
+	if (blob.rawSize != data.size())
+		return false;
+	if (!blob.compressed)
+		return std::ranges::equal(blob.data, data);
+
+	std::vector<Byte> raw(data.size());
+	return utils::lz_decompress(blob.data, raw) && std::ranges::equal(raw, data);
+}
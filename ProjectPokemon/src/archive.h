@@ -0,0 +1,222 @@
+#pragma once
+
+#include "common.h"
+
+namespace utils
+{
+	constexpr UInt64 fnv1a_basis = 0xCBF29CE484222325ULL;
+	constexpr UInt64 fnv1a_prime = 0x100000001B3ULL;
+
+	/* Stable across platforms and runs, unlike std::hash, so it can be stored on disk */
+	constexpr UInt64 fnv1a(std::string_view text, UInt64 hash = fnv1a_basis)
+	{
+		for (char c : text)
+			hash = (hash ^ static_cast<UInt8>(c)) * fnv1a_prime;
+		return hash;
+	}
+
+	inline UInt64 fnv1a(std::span<const Byte> bytes, UInt64 hash = fnv1a_basis)
+	{
+		for (Byte b : bytes)
+			hash = (hash ^ static_cast<UInt8>(b)) * fnv1a_prime;
+		return hash;
+	}
+
+	/* LZ77 block codec in the LZ4 sequence layout; fast to decode, no external dependency */
+	void lz_compress(std::span<const Byte> source, std::vector<Byte>& output);
+	bool lz_decompress(std::span<const Byte> source, std::span<Byte> output);
+}
+
+
+
+/* Read-only memory mapping of a whole file */
+class MappedFile
+{
+private:
+	const Byte* _data = nullptr;
+	Size _size = 0;
+
+public:
+	MappedFile() = default;
+	MappedFile(MappedFile&& other) noexcept;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+
+	MappedFile& operator= (MappedFile&& right) noexcept;
+	MappedFile& operator= (const MappedFile&) = delete;
+
+	bool open(const Path& path);
+	void close();
+
+	inline bool isOpen() const { return _data; }
+	inline const Byte* data() const { return _data; }
+	inline Size size() const { return _size; }
+	inline std::span<const Byte> bytes() const { return { _data, _size }; }
+};
+
+
+
+/* istream source over a block of memory that outlives the stream */
+class MemoryStreamBuffer : public std::streambuf
+{
+public:
+	explicit MemoryStreamBuffer(std::span<const Byte> bytes);
+
+protected:
+	pos_type seekoff(off_type offset, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+	pos_type seekpos(pos_type position, std::ios_base::openmode which) override;
+};
+
+
+
+struct ArchiveHeader
+{
+	static constexpr UInt32 magic_value = 0x52414B50; // "PKAR"
+	static constexpr UInt32 current_version = 1;
+
+	UInt32 magic;
+	UInt32 version;
+	UInt32 entryCount;
+	UInt32 alignment;
+	UInt64 indexOffset;
+	UInt64 namesOffset;
+	UInt64 namesSize;
+};
+
+struct ArchiveEntry
+{
+	static constexpr UInt32 compressed = 0x1;
+
+	UInt64 hash;
+	UInt64 offset;
+	UInt64 size;
+	UInt64 rawSize;
+	UInt32 nameOffset;
+	UInt32 nameLength;
+	UInt32 flags;
+	UInt32 reserved;
+
+	inline bool isCompressed() const { return flags & compressed; }
+};
+
+static_assert(sizeof(ArchiveHeader) == 40 && sizeof(ArchiveEntry) == 48, "archive layout must not depend on the compiler");
+static_assert(std::endian::native == std::endian::little, "archives are stored little endian");
+
+
+
+/*
+ * Packed resource file. The header, the index sorted by path hash and the
+ * entry data are read straight out of a memory mapping, so opening an archive
+ * costs a single open() and lookups are a binary search. Uncompressed entries
+ * can be viewed in place; views stay valid while the archive is alive.
+ */
+class Archive
+{
+private:
+	MappedFile _file;
+	Path _path;
+	const ArchiveHeader* _header = nullptr;
+	std::span<const ArchiveEntry> _entries;
+	std::string_view _names;
+
+public:
+	Archive() = default;
+	~Archive() = default;
+
+	Archive(const Archive&) = delete;
+	Archive(Archive&&) = delete;
+
+	Archive& operator= (const Archive&) = delete;
+	Archive& operator= (Archive&&) = delete;
+
+public:
+	bool open(const Path& path);
+	void close();
+
+	inline bool isOpen() const { return _header; }
+	inline const Path& path() const { return _path; }
+
+	/* name must be normalized like nameOf(path) */
+	const ArchiveEntry* find(std::string_view name) const;
+	inline bool contains(std::string_view name) const { return find(name); }
+
+	inline std::string_view nameOf(const ArchiveEntry& entry) const { return _names.substr(entry.nameOffset, entry.nameLength); }
+
+	/* Stored bytes of the entry; only the resource itself when the entry is not compressed */
+	inline std::span<const Byte> view(const ArchiveEntry& entry) const { return _file.bytes().subspan(entry.offset, entry.size); }
+
+	bool read(const ArchiveEntry& entry, std::span<Byte> output) const;
+	bool read(const ArchiveEntry& entry, std::pmr::vector<Byte>& bytes) const;
+	bool read(const ArchiveEntry& entry, std::pmr::string& text) const;
+
+	inline std::span<const ArchiveEntry> entries() const { return _entries; }
+	inline Size size() const { return _entries.size(); }
+
+	static inline String nameOf(const Path& path) { return path.lexically_normal().generic_string(); }
+	static inline UInt64 hashOf(std::string_view name) { return utils::fnv1a(name); }
+};
+
+
+
+/*
+ * Builds archives offline. Entries with identical content share their data,
+ * and compression is only kept for entries it actually shrinks, so already
+ * compressed formats such as png or ogg stay viewable in place.
+ */
+class ArchiveWriter
+{
+public:
+	static constexpr UInt32 default_alignment = 16;
+	static constexpr Size min_compress_size = 256;
+
+private:
+	struct Blob
+	{
+		std::vector<Byte> data;
+		UInt64 contentHash;
+		UInt64 rawSize;
+		bool compressed;
+	};
+
+	struct Item
+	{
+		String name;
+		UInt64 hash;
+		Size blob;
+	};
+
+	std::vector<Blob> _blobs;
+	std::vector<Item> _items;
+	FlatHashMap<String, Size> _names;
+	FlatHashMap<UInt64, Size> _contents;
+	UInt32 _alignment;
+
+public:
+	explicit ArchiveWriter(UInt32 alignment = default_alignment);
+
+	ArchiveWriter(const ArchiveWriter&) = delete;
+	ArchiveWriter(ArchiveWriter&&) noexcept = default;
+
+	ArchiveWriter& operator= (const ArchiveWriter&) = delete;
+	ArchiveWriter& operator= (ArchiveWriter&&) noexcept = default;
+
+public:
+	bool add(const Path& name, std::span<const Byte> data, bool compress = true);
+	bool addFile(const Path& name, const Path& file, bool compress = true);
+	Size addDirectory(const Path& directory, bool compress = true);
+
+	bool write(const Path& path) const;
+
+	inline Size entryCount() const { return _items.size(); }
+	inline Size blobCount() const { return _blobs.size(); }
+	Size storedBytes() const;
+
+	void clear();
+
+	/* Fonts are read in place for as long as they are loaded, so they are always stored raw */
+	static bool mustStoreRaw(const Path& name);
+
+private:
+	static bool _matches(const Blob& blob, std::span<const Byte> data);
+};
@@ -0,0 +1,105 @@
+#include "arena.h"
+
+LinearArena::LinearArena(Size chunkSize, std::pmr::memory_resource* upstream) :
+	_upstream{ upstream ? upstream : std::pmr::get_default_resource() },
+	_chunkSize{ std::max<Size>(chunkSize, 256) }
+{}
+
+LinearArena::~LinearArena()
+{
+	_freeChunks();
+}
+
+void LinearArena::reset()
+{
+	if (_chunkCount > 1)
+	{
+		Size capacity = _reserved;
+		_freeChunks();
+		_grow(capacity, alignof(std::max_align_t));
+	}
+	else if (_chunks)
+	{
+		_cursor = reinterpret_cast<char*>(_chunks) + _headerSize(_chunks->alignment);
+		_end = reinterpret_cast<char*>(_chunks) + _chunks->size;
+	}
+	_used = 0;
+}
+
+void LinearArena::release()
+{
+	_freeChunks();
+	_used = 0;
+}
+
+void* LinearArena::do_allocate(Size bytes, Size alignment)
+{
+	Size space = static_cast<Size>(_end - _cursor);
+	void* ptr = _cursor;
+	if (!_cursor || !std::align(alignment, bytes, ptr, space))
+	{
+		_grow(bytes, alignment);
+		ptr = _cursor;
+	}
+
+	_cursor = static_cast<char*>(ptr) + bytes;
+	_used += bytes;
+	_peak = std::max(_peak, _used);
+	return ptr;
+}
+
+void LinearArena::_grow(Size bytes, Size alignment)
+{
+	alignment = std::max(alignment, alignof(std::max_align_t));
+	Size header = _headerSize(alignment);
+	Size size = std::max(_chunkSize, header + bytes);
+
+	Chunk* chunk = static_cast<Chunk*>(_upstream->allocate(size, alignment));
+	*chunk = { _chunks, size, alignment };
+	_chunks = chunk;
+	_cursor = reinterpret_cast<char*>(chunk) + header;
+	_end = reinterpret_cast<char*>(chunk) + size;
+	_reserved += size;
+	++_chunkCount;
+}
+
+void LinearArena::_freeChunks()
+{
+	while (_chunks)
+	{
+		Chunk* next = _chunks->next;
+		_upstream->deallocate(_chunks, _chunks->size, _chunks->alignment);
+		_chunks = next;
+	}
+	_cursor = _end = nullptr;
+	_chunkCount = 0;
+	_reserved = 0;
+}
+
+
+
+SceneArena::~SceneArena()
+{
+	_finalize();
+}
+
+void SceneArena::reset()
+{
+	_finalize();
+	LinearArena::reset();
+}
+
+void SceneArena::release()
+{
+	_finalize();
+	LinearArena::release();
+}
+
+void SceneArena::_finalize()
+{
+	for (Finalizer* finalizer = _finalizers; finalizer; finalizer = finalizer->next)
+		finalizer->destroy(finalizer->object);
+
+	_finalizers = nullptr;
+	_finalizerCount = 0;
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "common.h"
+
+/*
+ * Bump allocator exposed as a std::pmr::memory_resource. Individual
+ * deallocations are no-ops; memory is reclaimed all at once by reset(), which
+ * keeps the reserved capacity (merged into a single chunk), or by release(),
+ * which hands every chunk back to the upstream resource.
+ */
+class LinearArena : public std::pmr::memory_resource
+{
+public:
+	static constexpr Size default_chunk_size = 64 * 1024;
+
+private:
+	struct Chunk
+	{
+		Chunk* next;
+		Size size;
+		Size alignment;
+	};
+
+	std::pmr::memory_resource* _upstream;
+	Size _chunkSize;
+	Chunk* _chunks = nullptr;
+	char* _cursor = nullptr;
+	char* _end = nullptr;
+	Size _chunkCount = 0;
+	Size _reserved = 0;
+	Size _used = 0;
+	Size _peak = 0;
+
+public:
+	explicit LinearArena(Size chunkSize = default_chunk_size, std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+	virtual ~LinearArena();
+
+	LinearArena(const LinearArena&) = delete;
+	LinearArena(LinearArena&&) = delete;
+
+	LinearArena& operator= (const LinearArena&) = delete;
+	LinearArena& operator= (LinearArena&&) = delete;
+
+public:
+	virtual void reset();
+	virtual void release();
+
+	inline Size used() const { return _used; }
+	inline Size peak() const { return _peak; }
+	inline Size reserved() const { return _reserved; }
+	inline Size chunkCount() const { return _chunkCount; }
+	inline std::pmr::memory_resource* upstream() const { return _upstream; }
+
+	template<typename _Ty = std::byte>
+	inline std::pmr::polymorphic_allocator<_Ty> allocator() { return this; }
+
+protected:
+	void* do_allocate(Size bytes, Size alignment) override;
+	inline void do_deallocate(void*, Size, Size) override {}
+	inline bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+private:
+	void _grow(Size bytes, Size alignment);
+	void _freeChunks();
+
+	static constexpr Size _headerSize(Size alignment) { return (sizeof(Chunk) + alignment - 1) & ~(alignment - 1); }
+};
+
+
+
+class FrameArena : public LinearArena
+{
+private:
+	UInt64 _frame = 0;
+
+public:
+	using LinearArena::LinearArena;
+
+	inline void nextFrame() { reset(), ++_frame; }
+	inline UInt64 frame() const { return _frame; }
+};
+
+
+
+/*
+ * Arena for objects that live as long as a scene. Trivially destructible
+ * objects cost nothing on release; for the rest create() records a finalizer
+ * inside the arena itself and release() runs them newest first.
+ */
+class SceneArena : public LinearArena
+{
+private:
+	struct Finalizer
+	{
+		Finalizer* next;
+		void (*destroy)(void*);
+		void* object;
+	};
+
+	Finalizer* _finalizers = nullptr;
+	Size _finalizerCount = 0;
+
+public:
+	using LinearArena::LinearArena;
+	~SceneArena() override;
+
+public:
+	template<typename _Ty, typename... _Args>
+	_Ty& create(_Args&&... args)
+	{
+		Finalizer* finalizer = nullptr;
+		if constexpr (!std::is_trivially_destructible_v<_Ty>)
+			finalizer = static_cast<Finalizer*>(allocate(sizeof(Finalizer), alignof(Finalizer)));
+
+		_Ty& obj = utils::construct(*static_cast<_Ty*>(allocate(sizeof(_Ty), alignof(_Ty))), std::forward<_Args>(args)...);
+		if constexpr (!std::is_trivially_destructible_v<_Ty>)
+		{
+			*finalizer = { _finalizers, [](void* ptr) { utils::destroy(*static_cast<_Ty*>(ptr)); }, &obj };
+			_finalizers = finalizer;
+			++_finalizerCount;
+		}
+		return obj;
+	}
+
+	void reset() override;
+	void release() override;
+
+	inline Size finalizerCount() const { return _finalizerCount; }
+
+private:
+	void _finalize();
+};
@@ -0,0 +1,97 @@
+#include "async_loader.h"
+
+bool AsyncResourceLoader<sf::SoundBuffer>::stage(const ResourceFolder& folder, const Path& path, Staged& staged)
+{
+	auto decode = [&staged](sf::InputSoundFile& file) {
+		staged.samples.resize(static_cast<Size>(file.getSampleCount()));
+		staged.channels = file.getChannelCount();
+		staged.sampleRate = file.getSampleRate();
+		staged.samples.resize(static_cast<Size>(file.read(staged.samples.data(), staged.samples.size())));
+		return true;
+	};
+
+	sf::InputSoundFile file;
+	if (!folder.isPacked(path))
+		return file.openFromFile(folder.pathOf(path).string()) && decode(file);
+
+	return folder.readBytes(path, [&file, &decode](std::span<const Byte> bytes) { return file.openFromMemory(bytes.data(), bytes.size()) && decode(file); });
+}
+
+AsyncLoader::AsyncLoader(JobSystem& jobs, ResourceManager& resources) :
+	_jobs{ jobs },
+	_resources{ resources }
+{}
+
+AsyncLoader::~AsyncLoader()
+{
+	for (const auto& entry : _inflight)
+		if (entry.second->_job)
+			_jobs.wait(entry.second->_job);
+}
+
+Size AsyncLoader::pump(const sf::Time& budget)
+{
+	sf::Clock clock;
+	Size count = 0;
+	while (count == 0 || clock.getElapsedTime() < budget)
+	{
+		ref<AsyncLoadState> state;
+		if (!_immediate.empty())
+		{
+			state = std::move(_immediate.front());
+			_immediate.pop_front();
+		}
+		else
+		{
+			std::scoped_lock lock{ _mutex };
+			if (_staged.empty())
+				break;
+
+			state = std::move(_staged.front());
+			_staged.pop_front();
+		}
+
+		if (state->status() == LoadStatus::staged)
+		{
+			_finish(*state);
+			++count;
+		}
+	}
+	return count;
+}
+
+void AsyncLoader::waitAll()
+{
+	std::vector<ref<AsyncLoadState>> states;
+	states.reserve(_inflight.size());
+	for (const auto& entry : _inflight)
+		states.push_back(entry.second);
+
+	for (const auto& state : states)
+		_wait(*state);
+}
+
+void AsyncLoader::_wait(AsyncLoadState& state)
+{
+	if (state._job)
+		_jobs.wait(state._job);
+	if (state.status() == LoadStatus::staged)
+		_finish(state);
+}
+
+void AsyncLoader::_finish(AsyncLoadState& state)
+{
+	// A staged job may still be about to publish itself under _mutex; the destructor only waits for inflight jobs
+	if (state._job)
+	{
+		_jobs.wait(state._job);
+		state._job = {};
+	}
+
+	auto it = _inflight.find({ state._key, state._type, state._reload });
+	if (it != _inflight.end() && it->second.get() == &state)
+		_inflight.erase(it);
+
+	state.finish(_resources);
+	++_completed;
+}
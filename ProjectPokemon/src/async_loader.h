@@ -0,0 +1,313 @@
+#pragma once
+
+#include "common.h"
+#include "jobs.h"
+#include "resource_cache.h"
+
+/*
+ * Splits a load in two: stage() runs on a worker and does the file I/O and
+ * decoding, finish() runs on the main thread and turns the staged data into
+ * the cached resource. Types without a specialization are loaded entirely on
+ * the main thread.
+ */
+template<typename _Ty>
+struct AsyncResourceLoader
+{
+	struct Staged {};
+
+	static inline bool stage(const ResourceFolder&, const Path&, Staged&) { return true; }
+	static inline bool finish(const ResourceFolder& folder, const Path& path, Staged&, _Ty& resource) { return ResourceLoader<_Ty>::load(folder, path, resource); }
+};
+
+template<>
+struct AsyncResourceLoader<sf::Image>
+{
+	typedef sf::Image Staged;
+
+	static inline bool stage(const ResourceFolder& folder, const Path& path, Staged& staged) { return ResourceLoader<sf::Image>::load(folder, path, staged); }
+	static inline bool finish(const ResourceFolder&, const Path&, Staged& staged, sf::Image& image) { return image = staged, true; }
+};
+
+template<>
+struct AsyncResourceLoader<sf::Texture>
+{
+	typedef sf::Image Staged;
+
+	static inline bool stage(const ResourceFolder& folder, const Path& path, Staged& staged) { return ResourceLoader<sf::Image>::load(folder, path, staged); }
+	static inline bool finish(const ResourceFolder&, const Path&, Staged& staged, sf::Texture& texture) { return texture.loadFromImage(staged); }
+};
+
+template<>
+struct AsyncResourceLoader<sf::SoundBuffer>
+{
+	struct Staged
+	{
+		std::vector<sf::Int16> samples;
+		UInt32 channels = 0;
+		UInt32 sampleRate = 0;
+	};
+
+	static bool stage(const ResourceFolder& folder, const Path& path, Staged& staged);
+	static inline bool finish(const ResourceFolder&, const Path&, Staged& staged, sf::SoundBuffer& buffer)
+	{
+		return buffer.loadFromSamples(staged.samples.data(), staged.samples.size(), staged.channels, staged.sampleRate);
+	}
+};
+
+template<>
+struct AsyncResourceLoader<Json>
+{
+	typedef Json Staged;
+
+	static inline bool stage(const ResourceFolder& folder, const Path& path, Staged& staged) { return folder.readJson(path, staged); }
+	static inline bool finish(const ResourceFolder&, const Path&, Staged& staged, Json& json) { return json = std::move(staged), true; }
+};
+
+
+
+enum class LoadStatus : UInt8
+{
+	pending,
+	staged,
+	ready,
+	failed
+};
+
+class AsyncLoadState
+{
+protected:
+	std::atomic<LoadStatus> _status = LoadStatus::pending;
+	bool _stageOk = false;
+	bool _reload = false;
+	Symbol _key;
+	std::type_index _type;
+	ResourceFolder _folder;
+	Path _path;
+	JobHandle _job;
+
+public:
+	inline AsyncLoadState(Symbol key, std::type_index type, const ResourceFolder& folder, const Path& path) : _key{ key }, _type{ type }, _folder{ folder }, _path{ path } {}
+	virtual ~AsyncLoadState() = default;
+
+	inline LoadStatus status() const { return _status.load(std::memory_order_acquire); }
+	inline Symbol key() const { return _key; }
+
+	virtual void stage() = 0;
+	virtual void finish(ResourceManager& resources) = 0;
+
+public:
+	friend class AsyncLoader;
+};
+
+template<typename _Ty>
+class TypedAsyncLoadState final : public AsyncLoadState
+{
+public:
+	typedef Function<void(const ResourceHandle<_Ty>&)> Callback;
+
+private:
+	typename AsyncResourceLoader<_Ty>::Staged _staged;
+	ResourceHandle<_Ty> _handle;
+	std::vector<Callback> _callbacks;
+
+public:
+	using AsyncLoadState::AsyncLoadState;
+
+	inline const ResourceHandle<_Ty>& handle() const { return _handle; }
+
+	bool resolveCached(ResourceManager& resources)
+	{
+		_handle = resources.cache<_Ty>().find(_key);
+		if (!_handle)
+			return false;
+
+		_stageOk = true;
+		_status.store(LoadStatus::staged, std::memory_order_release);
+		return true;
+	}
+
+	inline void addCallback(Callback&& callback)
+	{
+		if (callback)
+			_callbacks.push_back(std::move(callback));
+	}
+
+	void stage() override
+	{
+		try { _stageOk = AsyncResourceLoader<_Ty>::stage(_folder, _path, _staged); }
+		catch (const std::exception&) { _stageOk = false; }
+		_status.store(LoadStatus::staged, std::memory_order_release);
+	}
+
+	void finish(ResourceManager& resources) override
+	{
+		if (_stageOk && !_handle)
+		{
+			ResourceCache<_Ty>& cache = resources.cache<_Ty>();
+			if (!_reload)
+				_handle = cache.find(_key);
+			if (!_handle)
+				_handle = cache.emplace(_key, [this](_Ty& resource) { return AsyncResourceLoader<_Ty>::finish(_folder, _path, _staged, resource); });
+		}
+		_staged = {};
+		_status.store(_handle ? LoadStatus::ready : LoadStatus::failed, std::memory_order_release);
+
+		for (const Callback& callback : _callbacks)
+			callback(_handle);
+		_callbacks.clear();
+	}
+};
+
+
+
+/*
+ * Result of an asynchronous load. The handle becomes available once the load
+ * has been completed on the main thread by AsyncLoader::pump() or wait().
+ */
+template<typename _Ty>
+class ResourceRequest
+{
+private:
+	ref<TypedAsyncLoadState<_Ty>> _state;
+
+public:
+	ResourceRequest() = default;
+	ResourceRequest(const ResourceRequest&) = default;
+	ResourceRequest(ResourceRequest&&) noexcept = default;
+	~ResourceRequest() = default;
+
+	ResourceRequest& operator= (const ResourceRequest&) = default;
+	ResourceRequest& operator= (ResourceRequest&&) noexcept = default;
+
+	inline LoadStatus status() const { return _state ? _state->status() : LoadStatus::failed; }
+	inline bool done() const { return status() == LoadStatus::ready || status() == LoadStatus::failed; }
+	inline bool ready() const { return status() == LoadStatus::ready; }
+	inline bool failed() const { return status() == LoadStatus::failed; }
+
+	inline ResourceHandle<_Ty> handle() const { return ready() ? _state->handle() : ResourceHandle<_Ty>{}; }
+	inline Symbol key() const { return _state ? _state->key() : Symbol{}; }
+
+	inline operator bool() const { return static_cast<bool>(_state); }
+	inline bool operator! () const { return !_state; }
+
+private:
+	inline ResourceRequest(const ref<TypedAsyncLoadState<_Ty>>& state) : _state{ state } {}
+
+public:
+	friend class AsyncLoader;
+};
+
+
+
+/*
+ * Runs the staging half of resource loads on the JobSystem and completes them
+ * on the main thread inside pump(), which stops once its time budget is spent
+ * so a burst of finished loads cannot stall a frame. Requests for a resource
+ * that is already cached or in flight share the existing result. Reloads
+ * always read the file again and replace the cached value in place.
+ */
+class AsyncLoader
+{
+public:
+	static constexpr Int64 default_budget_us = 2000;
+
+private:
+	struct LoadKey
+	{
+		Symbol key;
+		std::type_index type;
+		bool reload;
+
+		inline bool operator== (const LoadKey&) const = default;
+
+		struct hash
+		{
+			inline Size operator() (const LoadKey& key) const { return Symbol::hash()(key.key) ^ key.type.hash_code() ^ static_cast<Size>(key.reload); }
+		};
+	};
+
+	JobSystem& _jobs;
+	ResourceManager& _resources;
+	FlatHashMap<LoadKey, ref<AsyncLoadState>, LoadKey::hash> _inflight;
+	std::deque<ref<AsyncLoadState>> _immediate;
+	std::mutex _mutex;
+	std::deque<ref<AsyncLoadState>> _staged;
+	Size _completed = 0;
+
+public:
+	AsyncLoader(JobSystem& jobs, ResourceManager& resources);
+	~AsyncLoader();
+
+	AsyncLoader(const AsyncLoader&) = delete;
+	AsyncLoader(AsyncLoader&&) = delete;
+
+	AsyncLoader& operator= (const AsyncLoader&) = delete;
+	AsyncLoader& operator= (AsyncLoader&&) = delete;
+
+public:
+	template<typename _Ty>
+	inline ResourceRequest<_Ty> load(const Path& path, typename TypedAsyncLoadState<_Ty>::Callback callback = {})
+	{
+		return _load<_Ty>(path, std::move(callback), false);
+	}
+
+	template<typename _Ty>
+	inline ResourceRequest<_Ty> load(Symbol filename, typename TypedAsyncLoadState<_Ty>::Callback callback = {})
+	{
+		return _load<_Ty>(Path{ filename.view() }, std::move(callback), false);
+	}
+
+	template<typename _Ty>
+	inline ResourceRequest<_Ty> reload(const Path& path, typename TypedAsyncLoadState<_Ty>::Callback callback = {})
+	{
+		return _load<_Ty>(path, std::move(callback), true);
+	}
+
+	Size pump(const sf::Time& budget = sf::microseconds(default_budget_us));
+
+	template<typename _Ty>
+	ResourceHandle<_Ty> wait(const ResourceRequest<_Ty>& request)
+	{
+		if (request)
+			_wait(*request._state);
+		return request.handle();
+	}
+
+	void waitAll();
+
+	inline Size pendingCount() const { return _inflight.size(); }
+	inline Size completedCount() const { return _completed; }
+
+private:
+	template<typename _Ty>
+	ResourceRequest<_Ty> _load(const Path& path, typename TypedAsyncLoadState<_Ty>::Callback&& callback, bool reload)
+	{
+		const ResourceFolder& root = _resources.root();
+		Symbol key = root.keyOf(path);
+
+		auto it = _inflight.find({ key, typeid(_Ty), reload });
+		if (it != _inflight.end())
+		{
+			auto state = std::static_pointer_cast<TypedAsyncLoadState<_Ty>>(it->second);
+			state->addCallback(std::move(callback));
+			return state;
+		}
+
+		auto state = std::make_shared<TypedAsyncLoadState<_Ty>>(key, typeid(_Ty), root, path);
+		state->_reload = reload;
+		state->addCallback(std::move(callback));
+		_inflight.emplace(LoadKey{ key, typeid(_Ty), reload }, state);
+
+		if (!reload && state->resolveCached(_resources))
+			_immediate.push_back(state);
+		else state->_job = _jobs.schedule([this, state] {
+			state->stage();
+			std::scoped_lock lock{ _mutex };
+			_staged.push_back(state);
+		});
+		return state;
+	}
+
+	void _wait(AsyncLoadState& state);
+	void _finish(AsyncLoadState& state);
+};
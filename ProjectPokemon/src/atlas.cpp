@@ -0,0 +1,411 @@
+#include "atlas.h"
+#include "resource_cache.h"
+
+namespace
+{
+	inline bool contains_rect(const IntRect& outer, const IntRect& inner)
+	{
+		return inner.left >= outer.left && inner.top >= outer.top &&
+			inner.left + inner.width <= outer.left + outer.width &&
+			inner.top + inner.height <= outer.top + outer.height;
+	}
+}
+
+MaxRectsPacker::MaxRectsPacker(const Vec2i& size)
+{
+	reset(size);
+}
+
+void MaxRectsPacker::reset(const Vec2i& size)
+{
+	_size = size;
+	_free.clear();
+	_free.push_back({ 0, 0, size.x, size.y });
+	_usedArea = 0;
+}
+
+std::optional<Vec2i> MaxRectsPacker::insert(const Vec2i& size)
+{
+	if (size.x <= 0 || size.y <= 0)
+		return std::nullopt;
+
+	const IntRect* best = nullptr;
+	Int32 bestShort = std::numeric_limits<Int32>::max();
+	Int32 bestLong = std::numeric_limits<Int32>::max();
+	for (const IntRect& rect : _free)
+	{
+		if (rect.width < size.x || rect.height < size.y)
+			continue;
+
+		Int32 leftoverX = rect.width - size.x;
+		Int32 leftoverY = rect.height - size.y;
+		Int32 shortSide = std::min(leftoverX, leftoverY);
+		Int32 longSide = std::max(leftoverX, leftoverY);
+		if (shortSide < bestShort || (shortSide == bestShort && longSide < bestLong))
+		{
+			best = &rect;
+			bestShort = shortSide;
+			bestLong = longSide;
+		}
+	}
+
+	if (!best)
+		return std::nullopt;
+
+	Vec2i position{ best->left, best->top };
+	occupy({ position.x, position.y, size.x, size.y });
+	return position;
+}
+
+void MaxRectsPacker::occupy(const IntRect& rect)
+{
+	IntRect used;
+	if (!rect.intersects({ 0, 0, _size.x, _size.y }, used))
+		return;
+
+	_usedArea += static_cast<Int64>(used.width) * used.height;
+	_split(used);
+	_prune();
+}
+
+void MaxRectsPacker::_split(const IntRect& used)
+{
+	Size count = _free.size();
+	for (Size i = 0; i < count;)
+	{
+		IntRect rect = _free[i];
+		if (!rect.intersects(used))
+		{
+			++i;
+			continue;
+		}
+
+		/* Up to four maximal rectangles remain around the used area */
+		if (used.left > rect.left)
+			_free.push_back({ rect.left, rect.top, used.left - rect.left, rect.height });
+		if (used.left + used.width < rect.left + rect.width)
+			_free.push_back({ used.left + used.width, rect.top, rect.left + rect.width - used.left - used.width, rect.height });
+		if (used.top > rect.top)
+			_free.push_back({ rect.left, rect.top, rect.width, used.top - rect.top });
+		if (used.top + used.height < rect.top + rect.height)
+			_free.push_back({ rect.left, used.top + used.height, rect.width, rect.top + rect.height - used.top - used.height });
+
+		_free[i] = _free[count - 1];
+		_free[count - 1] = _free.back();
+		_free.pop_back();
+		--count;
+	}
+}
+
+void MaxRectsPacker::_prune()
+{
+	for (Size i = 0; i < _free.size(); ++i)
+	{
+		for (Size j = i + 1; j < _free.size();)
+		{
+			if (contains_rect(_free[i], _free[j]))
+			{
+				_free[j] = _free.back();
+				_free.pop_back();
+			}
+			else if (contains_rect(_free[j], _free[i]))
+			{
+				_free[i] = _free[j];
+				_free[j] = _free.back();
+				_free.pop_back();
+				j = i + 1;
+			}
+			else ++j;
+		}
+	}
+}
+
+
+
+TextureAtlas::TextureAtlas(const AtlasSettings& settings) :
+	_settings{ settings }
+{}
+
+std::optional<AtlasRegion> TextureAtlas::add(Symbol name, const sf::Image& image)
+{
+	if (std::optional<AtlasRegion> existing = find(name))
+		return existing;
+
+	Vec2u imageSize = image.getSize();
+	IntRect source = _settings.trim ? _trimmed(image) : IntRect{ 0, 0, static_cast<Int32>(imageSize.x), static_cast<Int32>(imageSize.y) };
+
+	AtlasRegion region;
+	region.offset = { source.left, source.top };
+	region.sourceSize = { static_cast<Int32>(imageSize.x), static_cast<Int32>(imageSize.y) };
+
+	/* Fully transparent images keep their frame but take no space, nor a page */
+	if (source.width <= 0 || source.height <= 0)
+	{
+		region.rect = {};
+		region.page = AtlasRegion::no_page;
+		return _regions.insert_or_assign(name, region).first->second;
+	}
+
+	Int32 border = static_cast<Int32>(_settings.extrude);
+	Vec2i packed{ source.width + 2 * border + static_cast<Int32>(_settings.padding), source.height + 2 * border + static_cast<Int32>(_settings.padding) };
+
+	std::optional<Vec2i> position;
+	UInt32 index = 0;
+	for (; index < _pages.size() && !position; ++index)
+		position = _pages[index].packer.insert(packed);
+
+	if (position)
+		--index;
+	else
+	{
+		if (packed.x > static_cast<Int32>(_settings.pageSize) || packed.y > static_cast<Int32>(_settings.pageSize))
+			return std::nullopt;
+
+		position = _newPage().packer.insert(packed);
+		index = static_cast<UInt32>(_pages.size() - 1);
+	}
+
+	Page& page = _pages[index];
+	_blit(page, image, source, *position);
+	page.pending.push_back({ position->x, position->y, source.width + 2 * border, source.height + 2 * border });
+
+	region.rect = { position->x + border, position->y + border, source.width, source.height };
+	region.page = index;
+	return _regions.insert_or_assign(name, region).first->second;
+}
+
+std::optional<AtlasRegion> TextureAtlas::add(Symbol name, const ResourceFolder& folder, const Path& path)
+{
+	if (std::optional<AtlasRegion> existing = find(name))
+		return existing;
+
+	sf::Image image;
+	if (!ResourceLoader<sf::Image>::load(folder, path, image))
+		return std::nullopt;
+	return add(name, image);
+}
+
+Size TextureAtlas::addDirectory(const ResourceFolder& folder, const Path& directory)
+{
+	struct Source
+	{
+		Symbol name;
+		sf::Image image;
+	};
+
+	std::vector<Source> sources;
+	Function<void(const Path&)> collect = [&](const Path& current) {
+		for (const String& entry : folder.list(current))
+		{
+			if (entry.ends_with('/'))
+				collect(current / entry.substr(0, entry.size() - 1));
+			else if (Path path = current / entry; path.extension() == ".png")
+			{
+				Source& source = sources.emplace_back(Source{ Symbol{ path.generic_string() }, {} });
+				if (!ResourceLoader<sf::Image>::load(folder, path, source.image))
+					sources.pop_back();
+			}
+		}
+	};
+	collect(directory);
+
+	/* Largest first packs much tighter than load order */
+	std::ranges::sort(sources, std::greater<>{}, [](const Source& source) {
+		Vec2u size = source.image.getSize();
+		return std::pair{ std::max(size.x, size.y), size.x * size.y };
+	});
+
+	Size count = 0;
+	for (const Source& source : sources)
+		count += add(source.name, source.image).has_value();
+	return count;
+}
+
+std::optional<AtlasRegion> TextureAtlas::find(Symbol name) const
+{
+	auto it = _regions.find(name);
+	if (it == _regions.end())
+		return std::nullopt;
+	return it->second;
+}
+
+bool TextureAtlas::upload()
+{
+	bool success = true;
+	std::vector<sf::Uint8> pixels;
+	for (Page& page : _pages)
+	{
+		if (!page.uploaded)
+		{
+			page.uploaded = page.texture.loadFromImage(page.image);
+			success &= page.uploaded;
+			page.pending.clear();
+			continue;
+		}
+
+		const sf::Uint8* source = page.image.getPixelsPtr();
+		Size stride = static_cast<Size>(page.image.getSize().x) * 4;
+		for (const IntRect& rect : page.pending)
+		{
+			Size row = static_cast<Size>(rect.width) * 4;
+			pixels.resize(row * rect.height);
+			for (Int32 y = 0; y < rect.height; ++y)
+				std::memcpy(pixels.data() + y * row, source + (rect.top + y) * stride + static_cast<Size>(rect.left) * 4, row);
+
+			page.texture.update(pixels.data(), rect.width, rect.height, rect.left, rect.top);
+		}
+		page.pending.clear();
+	}
+	return success;
+}
+
+sf::Sprite TextureAtlas::sprite(Symbol name) const
+{
+	std::optional<AtlasRegion> region = find(name);
+	if (!region)
+		return {};
+
+	sf::Sprite sprite;
+	if (region->hasPage())
+		sprite = sf::Sprite{ _pages[region->page].texture, region->rect };
+	sprite.setOrigin(static_cast<float>(-region->offset.x), static_cast<float>(-region->offset.y));
+	return sprite;
+}
+
+bool TextureAtlas::save(const ResourceFolder& folder, const Path& name) const
+{
+	/* Pages are written as image files, which needs a real directory */
+	if (folder.isPacked() || folder.isVirtual())
+		return false;
+
+	String stem = name.generic_string();
+	Json json;
+	json["pageSize"] = _settings.pageSize;
+	json["padding"] = _settings.padding;
+	json["extrude"] = _settings.extrude;
+	json["pages"] = Json::array();
+	for (Size i = 0; i < _pages.size(); ++i)
+	{
+		String file = stem + "_" + std::to_string(i) + ".png";
+		if (!_pages[i].image.saveToFile(folder.pathOf(Path{ file }).string()))
+			return false;
+		json["pages"].push_back(file);
+	}
+
+	Json& regions = json["regions"] = Json::object();
+	for (const auto& [key, region] : _regions)
+	{
+		regions[key.str()] = {
+			{ "page", region.page },
+			{ "x", region.rect.left }, { "y", region.rect.top }, { "w", region.rect.width }, { "h", region.rect.height },
+			{ "ox", region.offset.x }, { "oy", region.offset.y }, { "sw", region.sourceSize.x }, { "sh", region.sourceSize.y }
+		};
+	}
+
+	return folder.writeJson(Path{ stem + ".json" }, json);
+}
+
+bool TextureAtlas::load(const ResourceFolder& folder, const Path& name)
+{
+	Json json;
+	if (!folder.readJson(Path{ name.generic_string() + ".json" }, json))
+		return false;
+
+	clear();
+	_settings.pageSize = json.value("pageSize", _settings.pageSize);
+	_settings.padding = json.value("padding", _settings.padding);
+	_settings.extrude = json.value("extrude", _settings.extrude);
+
+	for (const Json& file : json["pages"])
+	{
+		Page& page = _pages.emplace_back();
+		if (!ResourceLoader<sf::Image>::load(folder, Path{ file.get<String>() }, page.image))
+			return clear(), false;
+
+		Vec2u size = page.image.getSize();
+		page.packer.reset({ static_cast<Int32>(size.x), static_cast<Int32>(size.y) });
+	}
+
+	/* Restores the packed areas so runtime additions go around them */
+	Int32 border = static_cast<Int32>(_settings.extrude);
+	Int32 padding = static_cast<Int32>(_settings.padding);
+	for (const auto& [key, value] : json["regions"].items())
+	{
+		AtlasRegion region;
+		region.page = value.at("page").get<UInt32>();
+		region.rect = { value.at("x").get<Int32>(), value.at("y").get<Int32>(), value.at("w").get<Int32>(), value.at("h").get<Int32>() };
+		region.offset = { value.at("ox").get<Int32>(), value.at("oy").get<Int32>() };
+		region.sourceSize = { value.at("sw").get<Int32>(), value.at("sh").get<Int32>() };
+		if (region.rect.width <= 0 || region.rect.height <= 0)
+			region.page = AtlasRegion::no_page;
+		else if (region.page >= _pages.size())
+			return clear(), false;
+
+		if (region.hasPage())
+			_pages[region.page].packer.occupy({ region.rect.left - border, region.rect.top - border, region.rect.width + 2 * border + padding, region.rect.height + 2 * border + padding });
+		_regions.insert_or_assign(Symbol{ key }, region);
+	}
+	return true;
+}
+
+void TextureAtlas::clear()
+{
+	_pages.clear();
+	_regions.clear();
+}
+
+TextureAtlas::Page& TextureAtlas::_newPage()
+{
+	Page& page = _pages.emplace_back();
+	page.image.create(_settings.pageSize, _settings.pageSize, Color::Transparent);
+	page.packer.reset({ static_cast<Int32>(_settings.pageSize), static_cast<Int32>(_settings.pageSize) });
+	return page;
+}
+
+IntRect TextureAtlas::_trimmed(const sf::Image& image) const
+{
+	Vec2u size = image.getSize();
+	const sf::Uint8* pixels = image.getPixelsPtr();
+
+	Int32 left = static_cast<Int32>(size.x), top = static_cast<Int32>(size.y), right = -1, bottom = -1;
+	for (Int32 y = 0; y < static_cast<Int32>(size.y); ++y)
+	{
+		const sf::Uint8* row = pixels + static_cast<Size>(y) * size.x * 4;
+		for (Int32 x = 0; x < static_cast<Int32>(size.x); ++x)
+		{
+			if (row[x * 4 + 3] > _settings.alphaThreshold)
+			{
+				left = std::min(left, x);
+				right = std::max(right, x);
+				top = std::min(top, y);
+				bottom = std::max(bottom, y);
+			}
+		}
+	}
+
+	return right < 0 ? IntRect{} : IntRect{ left, top, right - left + 1, bottom - top + 1 };
+}
+
+void TextureAtlas::_blit(Page& page, const sf::Image& image, const IntRect& source, const Vec2i& position) const
+{
+	Int32 border = static_cast<Int32>(_settings.extrude);
+	page.image.copy(image, position.x + border, position.y + border, source);
+	if (border == 0)
+		return;
+
+	/* Extruded ring repeats the nearest edge pixel, corners included */
+	for (Int32 y = -border; y < source.height + border; ++y)
+	{
+		bool inner = y >= 0 && y < source.height;
+		for (Int32 x = -border; x < source.width + border; ++x)
+		{
+			if (inner && x == 0)
+				x = source.width;
+			if (x >= source.width + border)
+				break;
+
+			Color color = image.getPixel(source.left + utils::clamp(x, 0, source.width - 1), source.top + utils::clamp(y, 0, source.height - 1));
+			page.image.setPixel(position.x + border + x, position.y + border + y, color);
+		}
+	}
+}
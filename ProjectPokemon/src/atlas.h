@@ -0,0 +1,137 @@
+#pragma once
+
+#include "common.h"
+#include "resource.h"
+
+/*
+ * MaxRects bin packer: keeps every maximal free rectangle of the bin and
+ * places each new rectangle where it leaves the shortest leftover side.
+ */
+class MaxRectsPacker
+{
+private:
+	Vec2i _size;
+	std::vector<IntRect> _free;
+	Int64 _usedArea = 0;
+
+public:
+	MaxRectsPacker() = default;
+	explicit MaxRectsPacker(const Vec2i& size);
+	MaxRectsPacker(const MaxRectsPacker&) = default;
+	MaxRectsPacker(MaxRectsPacker&&) noexcept = default;
+	~MaxRectsPacker() = default;
+
+	MaxRectsPacker& operator= (const MaxRectsPacker&) = default;
+	MaxRectsPacker& operator= (MaxRectsPacker&&) noexcept = default;
+
+public:
+	void reset(const Vec2i& size);
+
+	std::optional<Vec2i> insert(const Vec2i& size);
+
+	/* Marks an area as used, e.g. when restoring a packed layout */
+	void occupy(const IntRect& rect);
+
+	inline const Vec2i& size() const { return _size; }
+	inline Size freeCount() const { return _free.size(); }
+	inline float occupancy() const { return _size.x > 0 && _size.y > 0 ? static_cast<float>(_usedArea) / (static_cast<float>(_size.x) * static_cast<float>(_size.y)) : 0.f; }
+
+private:
+	void _split(const IntRect& used);
+	void _prune();
+};
+
+
+
+struct AtlasSettings
+{
+	UInt32 pageSize = 2048;
+	UInt32 padding = 1;
+	UInt32 extrude = 1;
+	bool trim = true;
+	UInt8 alphaThreshold = 0;
+};
+
+struct AtlasRegion
+{
+	/* Page of regions that take no space, e.g. fully transparent images */
+	static constexpr UInt32 no_page = std::numeric_limits<UInt32>::max();
+
+	IntRect rect;
+	Vec2i offset;
+	Vec2i sourceSize;
+	UInt32 page = no_page;
+
+	inline bool hasPage() const { return page != no_page; }
+};
+
+
+
+/*
+ * Packs many small images into a few large pages so sprites share textures
+ * and batch together. Transparent borders are trimmed (offset and sourceSize
+ * keep the original frame) and edges are extruded so filtering does not bleed
+ * neighbours in. Works offline, saving the pages next to a json lookup table,
+ * and at runtime, where images added after the first upload() only send
+ * their own area to the GPU on the next one.
+ */
+class TextureAtlas
+{
+private:
+	struct Page
+	{
+		sf::Image image;
+		sf::Texture texture;
+		MaxRectsPacker packer;
+		std::vector<IntRect> pending;
+		bool uploaded = false;
+	};
+
+	AtlasSettings _settings;
+	std::deque<Page> _pages;
+	FlatHashMap<Symbol, AtlasRegion, Symbol::hash> _regions;
+
+public:
+	explicit TextureAtlas(const AtlasSettings& settings = {});
+
+	TextureAtlas(const TextureAtlas&) = delete;
+	TextureAtlas(TextureAtlas&&) = default;
+
+	TextureAtlas& operator= (const TextureAtlas&) = delete;
+	TextureAtlas& operator= (TextureAtlas&&) = default;
+
+public:
+	/* Returns the existing region when name is already packed, nothing when the image cannot fit a page */
+	std::optional<AtlasRegion> add(Symbol name, const sf::Image& image);
+	std::optional<AtlasRegion> add(Symbol name, const ResourceFolder& folder, const Path& path);
+
+	/* Packs every png below directory, largest first, named by their path relative to folder */
+	Size addDirectory(const ResourceFolder& folder, const Path& directory = {});
+
+	std::optional<AtlasRegion> find(Symbol name) const;
+	inline bool contains(Symbol name) const { return _regions.contains(name); }
+
+	/* Sends new pages and newly packed areas to their textures; needs a GL context */
+	bool upload();
+
+	/* page must be below pageCount(); regions without one have nothing to index */
+	inline const sf::Texture& texture(UInt32 page) const { return _pages[page].texture; }
+	inline const sf::Image& image(UInt32 page) const { return _pages[page].image; }
+	inline Size pageCount() const { return _pages.size(); }
+	inline Size size() const { return _regions.size(); }
+	inline const AtlasSettings& settings() const { return _settings; }
+
+	/* Sprite over the region, with its origin moved so trimmed sprites keep their original frame; texture-less for empty regions */
+	sf::Sprite sprite(Symbol name) const;
+
+	/* Writes name.json and one name_<page>.png per page */
+	bool save(const ResourceFolder& folder, const Path& name) const;
+	bool load(const ResourceFolder& folder, const Path& name);
+
+	void clear();
+
+private:
+	Page& _newPage();
+	IntRect _trimmed(const sf::Image& image) const;
+	void _blit(Page& page, const sf::Image& image, const IntRect& source, const Vec2i& position) const;
+};
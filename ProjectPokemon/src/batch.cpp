@@ -0,0 +1,117 @@
+#include "batch.h"
+
+void SpriteBatch::draw(const sf::Sprite& sprite, Int32 layer, const sf::BlendMode& blend)
+{
+	const IntRect& textureRect = sprite.getTextureRect();
+	sf::FloatRect rect{ 0, 0, static_cast<float>(std::abs(textureRect.width)), static_cast<float>(std::abs(textureRect.height)) };
+	draw(sprite.getTexture(), rect, textureRect, sprite.getColor(), sprite.getTransform(), layer, blend);
+}
+
+void SpriteBatch::draw(
+	const sf::Texture* texture,
+	const sf::FloatRect& rect,
+	const IntRect& textureRect,
+	const Color& color,
+	const sf::Transform& transform,
+	Int32 layer,
+	const sf::BlendMode& blend)
+{
+	float left = static_cast<float>(textureRect.left);
+	float top = static_cast<float>(textureRect.top);
+	float right = left + textureRect.width;
+	float bottom = top + textureRect.height;
+
+	sf::Vertex topLeft{ transform.transformPoint(rect.left, rect.top), color, { left, top } };
+	sf::Vertex topRight{ transform.transformPoint(rect.left + rect.width, rect.top), color, { right, top } };
+	sf::Vertex bottomLeft{ transform.transformPoint(rect.left, rect.top + rect.height), color, { left, bottom } };
+	sf::Vertex bottomRight{ transform.transformPoint(rect.left + rect.width, rect.top + rect.height), color, { right, bottom } };
+
+	std::vector<sf::Vertex>& vertices = _batchFor(texture, blend, layer).vertices;
+	vertices.push_back(topLeft);
+	vertices.push_back(topRight);
+	vertices.push_back(bottomLeft);
+	vertices.push_back(bottomLeft);
+	vertices.push_back(topRight);
+	vertices.push_back(bottomRight);
+}
+
+void SpriteBatch::flush(sf::RenderTarget& target, const sf::RenderStates& states)
+{
+	if (_active == 0)
+		return;
+
+	for (Size index : _sortedOrder())
+	{
+		const Batch& batch = _batches[index];
+		sf::RenderStates batchStates{ states };
+		batchStates.texture = batch.texture;
+		batchStates.blendMode = batch.blend;
+		target.draw(batch.vertices.data(), batch.vertices.size(), sf::Triangles, batchStates);
+		++_stats.drawCalls;
+	}
+
+	_stats.sprites += spriteCount();
+	_stats.batches += _active;
+	++_stats.flushes;
+	clear();
+}
+
+void SpriteBatch::clear()
+{
+	for (Size i = 0; i < _active; ++i)
+		_batches[i].vertices.clear();
+	_active = 0;
+	_last = 0;
+}
+
+Size SpriteBatch::spriteCount() const
+{
+	Size count = 0;
+	for (Size i = 0; i < _active; ++i)
+		count += _batches[i].vertices.size() / vertices_per_sprite;
+	return count;
+}
+
+SpriteBatch::Batch& SpriteBatch::_batchFor(const sf::Texture* texture, const sf::BlendMode& blend, Int32 layer)
+{
+	auto matches = [texture, &blend, layer](const Batch& batch) {
+		return batch.texture == texture && batch.layer == layer && batch.blend == blend;
+	};
+
+	if (_last < _active && matches(_batches[_last]))
+		return _batches[_last];
+
+	for (Size i = 0; i < _active; ++i)
+	{
+		if (matches(_batches[i]))
+		{
+			_last = i;
+			return _batches[i];
+		}
+	}
+
+	if (_active == _batches.size())
+		_batches.push_back({ layer, texture, blend, {} });
+	else
+	{
+		Batch& batch = _batches[_active];
+		batch.layer = layer;
+		batch.texture = texture;
+		batch.blend = blend;
+	}
+
+	_last = _active++;
+	return _batches[_last];
+}
+
+std::vector<Size> SpriteBatch::_sortedOrder() const
+{
+	std::vector<Size> order(_active);
+	for (Size i = 0; i < _active; ++i)
+		order[i] = i;
+
+	std::stable_sort(order.begin(), order.end(), [this](Size left, Size right) {
+		return _batches[left].layer < _batches[right].layer;
+	});
+	return order;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "common.h"
+
+struct BatchStats
+{
+	Size sprites = 0;
+	Size batches = 0;
+	Size drawCalls = 0;
+	Size flushes = 0;
+};
+
+class SpriteBatch
+{
+public:
+	static constexpr Size vertices_per_sprite = 6;
+
+private:
+	struct Batch
+	{
+		Int32 layer;
+		const sf::Texture* texture;
+		sf::BlendMode blend;
+		std::vector<sf::Vertex> vertices;
+	};
+
+	std::vector<Batch> _batches;
+	Size _active = 0;
+	Size _last = 0;
+	BatchStats _stats;
+
+public:
+	SpriteBatch() = default;
+	SpriteBatch(const SpriteBatch&) = default;
+	SpriteBatch(SpriteBatch&&) noexcept = default;
+	~SpriteBatch() = default;
+
+	SpriteBatch& operator= (const SpriteBatch&) = default;
+	SpriteBatch& operator= (SpriteBatch&&) noexcept = default;
+
+public:
+	void draw(const sf::Sprite& sprite, Int32 layer = 0, const sf::BlendMode& blend = sf::BlendAlpha);
+
+	void draw(
+		const sf::Texture* texture,
+		const sf::FloatRect& rect,
+		const IntRect& textureRect,
+		const Color& color = Color::White,
+		const sf::Transform& transform = sf::Transform::Identity,
+		Int32 layer = 0,
+		const sf::BlendMode& blend = sf::BlendAlpha
+	);
+
+	void flush(sf::RenderTarget& target, const sf::RenderStates& states = sf::RenderStates::Default);
+	void clear();
+
+	inline bool empty() const { return _active == 0; }
+	inline Size batchCount() const { return _active; }
+	Size spriteCount() const;
+
+	template<typename _Fty>
+	void forEachBatch(_Fty&& action) const
+	{
+		for (Size index : _sortedOrder())
+		{
+			const Batch& batch = _batches[index];
+			action(batch.texture, batch.blend, batch.layer, batch.vertices);
+		}
+	}
+
+	inline const BatchStats& stats() const { return _stats; }
+	inline void resetStats() { _stats = {}; }
+
+private:
+	Batch& _batchFor(const sf::Texture* texture, const sf::BlendMode& blend, Int32 layer);
+	std::vector<Size> _sortedOrder() const;
+};
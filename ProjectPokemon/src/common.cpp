@@ -1,11 +1,36 @@
 #include "common.h"
 #include "json.h"
 
+namespace
+{
+	constexpr Int64 id_block_size = 1024;
+
+	struct IdBlock
+	{
+		Int64 next = 0;
+		Int64 end = 0;
+	};
+
+	std::atomic<Int64> next_id_block = 0;
+	thread_local IdBlock local_ids;
+}
+
+/*
+ * Each thread reserves blocks of ids from a shared counter and hands them out
+ * without synchronization. Ids are increasing per thread, and a single thread
+ * spawning alone gets the plain sequence 1, 2, 3...
+ */
 UniqueId UniqueId::make()
 {
-	static Int64 generator = 0;
+	if (local_ids.next == local_ids.end)
+	{
+		Int64 block = next_id_block.fetch_add(1, std::memory_order_relaxed);
+		local_ids.next = block * id_block_size + 1;
+		local_ids.end = local_ids.next + id_block_size;
+	}
+
 	UniqueId id;
-	id._id = ++generator;
+	id._id = local_ids.next++;
 	return id;
 }
 
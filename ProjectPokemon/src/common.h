@@ -1,9 +1,15 @@
 #pragma once
 
+#include <condition_variable>
+#include <memory_resource>
 #include <unordered_map>
+#include <shared_mutex>
 #include <type_traits>
+#include <string_view>
 #include <functional>
 #include <filesystem>
+#include <typeindex>
+#include <optional>
 #include <algorithm>
 #include <exception>
 #include <iostream>
@@ -13,18 +19,31 @@
 #include <fstream>
 #include <compare>
 #include <utility>
+#include <atomic>
+#include <thread>
 #include <chrono>
 #include <random>
+#include <limits>
 #include <memory>
+#include <cstring>
+#include <cassert>
 #include <vector>
 #include <string>
+#include <array>
+#include <tuple>
+#include <mutex>
 #include <queue>
+#include <deque>
 #include <cmath>
+#include <bit>
+#include <ranges>
+#include <span>
 #include <list>
 #include <map>
 #include <new>
 
 #include <sfml/Graphics.hpp>
+#include <sfml/Audio.hpp>
 
 #include <native_json/json.hpp>
 
@@ -145,6 +164,16 @@ namespace utils
 	inline Path operator"" _p(const char* str, Size size) { return String{ str, size }; }
 }
 
+namespace utils
+{
+	constexpr UInt64 mix_bits(UInt64 value)
+	{
+		value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+		return value ^ (value >> 31);
+	}
+}
+
 class UniqueId
 {
 private:
@@ -174,10 +203,61 @@ public:
 public:
 	struct hash
 	{
-		inline Size operator() (const UniqueId& id)
+		inline Size operator() (const UniqueId& id) const
+		{
+			return static_cast<Size>(utils::mix_bits(static_cast<UInt64>(id._id)));
+		}
+	};
+};
+
+
+
+/*
+ * 32 bit handle for hot containers: the low index_bits address a slot and the
+ * remaining bits hold a wrapping generation counter.
+ */
+class CompactId
+{
+public:
+	static constexpr UInt32 index_bits = 24;
+	static constexpr UInt32 generation_bits = 32 - index_bits;
+	static constexpr UInt32 index_mask = (UInt32(1) << index_bits) - 1;
+	static constexpr UInt32 generation_mask = (UInt32(1) << generation_bits) - 1;
+	static constexpr UInt32 invalid_index = index_mask;
+
+private:
+	UInt32 _bits = invalid_index;
+
+public:
+	constexpr CompactId() = default;
+	constexpr CompactId(const CompactId&) = default;
+	constexpr CompactId(UInt32 index, UInt32 generation) : _bits{ (index & index_mask) | ((generation & generation_mask) << index_bits) } {}
+	~CompactId() = default;
+
+	constexpr CompactId& operator= (const CompactId&) = default;
+
+	constexpr bool operator== (const CompactId&) const = default;
+	constexpr auto operator<=> (const CompactId&) const = default;
+
+	constexpr UInt32 index() const { return _bits & index_mask; }
+	constexpr UInt32 generation() const { return _bits >> index_bits; }
+	constexpr UInt32 bits() const { return _bits; }
+
+	constexpr operator bool() const { return index() != invalid_index; }
+	constexpr bool operator! () const { return index() == invalid_index; }
+
+	static constexpr CompactId fromBits(UInt32 bits) { CompactId id; id._bits = bits; return id; }
+
+	friend inline std::ostream& operator<< (std::ostream& left, const CompactId& right) { return left << right.index() << ':' << right.generation(); }
+
+public:
+	struct hash
+	{
+		inline Size operator() (const CompactId& id) const
 		{
-			return std::hash<Int64>()(id);
+			return static_cast<Size>(utils::mix_bits(id._bits));
 		}
 	};
 };
 
+#include "flat_hash_map.h"
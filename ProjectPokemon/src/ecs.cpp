@@ -0,0 +1,229 @@
+#include "ecs.h"
+
+namespace
+{
+	std::mutex component_types_mutex;
+	std::vector<uref<ComponentType>>& component_types()
+	{
+		static std::vector<uref<ComponentType>> types;
+		return types;
+	}
+}
+
+ComponentType::ComponentType(ComponentTypeId id, Size size, MoveConstructor move, Destructor destroy) :
+	_id{ id },
+	_size{ size },
+	_move{ move },
+	_destroy{ destroy }
+{}
+
+const ComponentType& ComponentType::get(ComponentTypeId id)
+{
+	std::scoped_lock lock{ component_types_mutex };
+	return *component_types()[id];
+}
+
+const ComponentType& ComponentType::_register(Size size, MoveConstructor move, Destructor destroy)
+{
+	std::scoped_lock lock{ component_types_mutex };
+	auto& types = component_types();
+	if (types.size() >= max_types)
+		throw std::length_error{ "Too many component types" };
+
+	types.emplace_back(new ComponentType{ static_cast<ComponentTypeId>(types.size()), size, move, destroy });
+	return *types.back();
+}
+
+
+
+ComponentColumn::ComponentColumn(const ComponentType& type) :
+	_type{ &type }
+{}
+
+ComponentColumn::ComponentColumn(ComponentColumn&& other) noexcept :
+	_type{ other._type },
+	_data{ std::exchange(other._data, nullptr) },
+	_size{ std::exchange(other._size, 0) },
+	_capacity{ std::exchange(other._capacity, 0) }
+{}
+
+ComponentColumn::~ComponentColumn()
+{
+	for (Size i = 0; i < _size; ++i)
+		_type->destroy(at(i));
+	utils::raw_free(_data);
+}
+
+void* ComponentColumn::pushUninitialized()
+{
+	if (_size == _capacity)
+		reserve(_capacity == 0 ? 16 : _capacity * 2);
+	return at(_size++);
+}
+
+void ComponentColumn::pushMoved(void* src)
+{
+	if (_size == _capacity)
+		reserve(_capacity == 0 ? 16 : _capacity * 2);
+	_type->moveConstruct(at(_size), src);
+	++_size;
+}
+
+void ComponentColumn::swapRemove(Size row)
+{
+	Size last = _size - 1;
+	_type->destroy(at(row));
+	if (row != last)
+	{
+		_type->moveConstruct(at(row), at(last));
+		_type->destroy(at(last));
+	}
+	--_size;
+}
+
+void ComponentColumn::reserve(Size capacity)
+{
+	if (capacity <= _capacity)
+		return;
+
+	Byte* data = utils::raw_malloc<Byte>(capacity * _type->size());
+	for (Size i = 0; i < _size; ++i)
+	{
+		_type->moveConstruct(data + i * _type->size(), at(i));
+		_type->destroy(at(i));
+	}
+	utils::raw_free(_data);
+
+	_data = data;
+	_capacity = capacity;
+}
+
+
+
+Archetype::Archetype(ComponentMask mask) :
+	_mask{ mask }
+{
+	_columnIndex.fill(no_column);
+	for (ComponentTypeId id = 0; id < ComponentType::max_types; ++id)
+	{
+		if (mask & (ComponentMask(1) << id))
+		{
+			_columnIndex[id] = static_cast<UInt8>(_columns.size());
+			_columns.emplace_back(ComponentType::get(id));
+		}
+	}
+}
+
+Size Archetype::pushEntity(Entity entity)
+{
+	_entities.push_back(entity);
+	return _entities.size() - 1;
+}
+
+Entity Archetype::swapRemove(Size row)
+{
+	for (ComponentColumn& column : _columns)
+		column.swapRemove(row);
+
+	Entity moved = _entities.back();
+	_entities[row] = moved;
+	_entities.pop_back();
+	return row == _entities.size() ? Entity{} : moved;
+}
+
+Size Archetype::moveEntityTo(Size row, Archetype& dst)
+{
+	for (ComponentColumn& column : _columns)
+	{
+		ComponentColumn* target = dst.column(column.type().id());
+		if (target)
+			target->pushMoved(column.at(row));
+	}
+	return dst.pushEntity(_entities[row]);
+}
+
+
+
+EntityRegistry::EntityRegistry()
+{
+	_archetypeOf(0);
+}
+
+Entity EntityRegistry::create(UniqueId uid)
+{
+	if (!uid || _ids.contains(uid))
+		return {};
+
+	Archetype& empty = *_archetypes.front();
+	Entity entity = _records.insert({ &empty, 0, uid });
+	_records[entity].row = empty.pushEntity(entity);
+	_ids.emplace(uid, entity);
+	return entity;
+}
+
+bool EntityRegistry::destroy(Entity entity)
+{
+	if (!alive(entity))
+		return false;
+
+	Record& record = _records[entity];
+	_fixupMoved(record.archetype->swapRemove(record.row), record.row);
+	_ids.erase(record.uid);
+	return _records.erase(entity);
+}
+
+Entity EntityRegistry::findByUid(UniqueId uid) const
+{
+	auto it = _ids.find(uid);
+	return it == _ids.end() ? Entity{} : it->second;
+}
+
+const std::vector<Archetype*>& EntityRegistry::archetypesMatching(ComponentMask required)
+{
+	QueryCache& cache = _queries[required];
+	for (; cache.seen < _archetypes.size(); ++cache.seen)
+	{
+		Archetype* archetype = _archetypes[cache.seen].get();
+		if (archetype->matches(required))
+			cache.archetypes.push_back(archetype);
+	}
+	return cache.archetypes;
+}
+
+Archetype& EntityRegistry::_archetypeOf(ComponentMask mask)
+{
+	auto it = _archetypesByMask.find(mask);
+	if (it != _archetypesByMask.end())
+		return *it->second;
+
+	Archetype* archetype = _archetypes.emplace_back(new Archetype{ mask }).get();
+	_archetypesByMask.emplace(mask, archetype);
+	return *archetype;
+}
+
+Archetype* EntityRegistry::_nextArchetype(Archetype& src, const ComponentType& type, bool add)
+{
+	auto& edges = add ? src._addEdges : src._removeEdges;
+	auto it = edges.find(type.id());
+	if (it != edges.end())
+		return it->second;
+
+	Archetype* dst = &_archetypeOf(add ? src._mask | type.mask() : src._mask & ~type.mask());
+	edges.emplace(type.id(), dst);
+	return dst;
+}
+
+void EntityRegistry::_migrate(Record& record, Archetype& dst)
+{
+	Size row = record.archetype->moveEntityTo(record.row, dst);
+	_fixupMoved(record.archetype->swapRemove(record.row), record.row);
+
+	record.archetype = &dst;
+	record.row = row;
+}
+
+void EntityRegistry::_fixupMoved(Entity moved, Size row)
+{
+	if (moved)
+		_records[moved].row = row;
+}
@@ -0,0 +1,269 @@
+#pragma once
+
+#include "common.h"
+#include "slot_map.h"
+
+typedef UInt32 ComponentTypeId;
+typedef UInt64 ComponentMask;
+typedef SlotHandle Entity;
+
+class ComponentType
+{
+public:
+	static constexpr ComponentTypeId max_types = sizeof(ComponentMask) * 8;
+
+	typedef void (*MoveConstructor)(void* dst, void* src);
+	typedef void (*Destructor)(void* obj);
+
+private:
+	ComponentTypeId _id;
+	Size _size;
+	MoveConstructor _move;
+	Destructor _destroy;
+
+public:
+	ComponentType(const ComponentType&) = delete;
+	ComponentType& operator= (const ComponentType&) = delete;
+
+	inline ComponentTypeId id() const { return _id; }
+	inline Size size() const { return _size; }
+	inline ComponentMask mask() const { return ComponentMask(1) << _id; }
+
+	inline void moveConstruct(void* dst, void* src) const { _move(dst, src); }
+	inline void destroy(void* obj) const { _destroy(obj); }
+
+	static const ComponentType& get(ComponentTypeId id);
+
+	template<typename _Ty>
+	static const ComponentType& of()
+	{
+		static_assert(alignof(_Ty) <= alignof(std::max_align_t), "Over-aligned components are not supported");
+		static const ComponentType& type = _register(
+			sizeof(_Ty),
+			[](void* dst, void* src) { new (dst) _Ty(std::move(*reinterpret_cast<_Ty*>(src))); },
+			[](void* obj) { reinterpret_cast<_Ty*>(obj)->~_Ty(); }
+		);
+		return type;
+	}
+
+	template<typename... _Tys>
+	static inline ComponentMask maskOf() { return (ComponentMask(0) | ... | of<_Tys>().mask()); }
+
+private:
+	ComponentType(ComponentTypeId id, Size size, MoveConstructor move, Destructor destroy);
+
+	static const ComponentType& _register(Size size, MoveConstructor move, Destructor destroy);
+};
+
+
+
+class ComponentColumn
+{
+private:
+	const ComponentType* _type;
+	Byte* _data = nullptr;
+	Size _size = 0;
+	Size _capacity = 0;
+
+public:
+	explicit ComponentColumn(const ComponentType& type);
+	ComponentColumn(ComponentColumn&& other) noexcept;
+	~ComponentColumn();
+
+	ComponentColumn(const ComponentColumn&) = delete;
+	ComponentColumn& operator= (const ComponentColumn&) = delete;
+	ComponentColumn& operator= (ComponentColumn&&) = delete;
+
+	inline const ComponentType& type() const { return *_type; }
+	inline Size size() const { return _size; }
+
+	inline void* at(Size row) { return _data + row * _type->size(); }
+	inline const void* at(Size row) const { return _data + row * _type->size(); }
+
+	template<typename _Ty>
+	inline _Ty* data() { return reinterpret_cast<_Ty*>(_data); }
+
+	void* pushUninitialized();
+	void pushMoved(void* src);
+	void swapRemove(Size row);
+	void reserve(Size capacity);
+};
+
+
+
+class Archetype
+{
+private:
+	static constexpr UInt8 no_column = 0xFF;
+
+	ComponentMask _mask;
+	std::vector<ComponentColumn> _columns;
+	std::array<UInt8, ComponentType::max_types> _columnIndex;
+	std::vector<Entity> _entities;
+	std::unordered_map<ComponentTypeId, Archetype*> _addEdges;
+	std::unordered_map<ComponentTypeId, Archetype*> _removeEdges;
+
+public:
+	explicit Archetype(ComponentMask mask);
+	Archetype(const Archetype&) = delete;
+	Archetype& operator= (const Archetype&) = delete;
+
+	inline ComponentMask mask() const { return _mask; }
+	inline Size size() const { return _entities.size(); }
+	inline bool empty() const { return _entities.empty(); }
+	inline bool matches(ComponentMask required) const { return (_mask & required) == required; }
+
+	inline Entity entityAt(Size row) const { return _entities[row]; }
+
+	inline ComponentColumn* column(ComponentTypeId type) { return _columnIndex[type] == no_column ? nullptr : &_columns[_columnIndex[type]]; }
+	inline const ComponentColumn* column(ComponentTypeId type) const { return _columnIndex[type] == no_column ? nullptr : &_columns[_columnIndex[type]]; }
+
+	template<typename _Ty>
+	inline _Ty* columnData() { return column(ComponentType::of<_Ty>().id())->template data<_Ty>(); }
+
+	Size pushEntity(Entity entity);
+	Entity swapRemove(Size row);
+	Size moveEntityTo(Size row, Archetype& dst);
+
+public:
+	friend class EntityRegistry;
+};
+
+
+
+class EntityRegistry
+{
+private:
+	struct Record
+	{
+		Archetype* archetype;
+		Size row;
+		UniqueId uid;
+	};
+
+	struct QueryCache
+	{
+		std::vector<Archetype*> archetypes;
+		Size seen = 0;
+	};
+
+	SlotMap<Record> _records;
+	FlatHashMap<UniqueId, Entity, UniqueId::hash> _ids;
+	std::vector<uref<Archetype>> _archetypes;
+	std::unordered_map<ComponentMask, Archetype*> _archetypesByMask;
+	std::unordered_map<ComponentMask, QueryCache> _queries;
+
+public:
+	EntityRegistry();
+	EntityRegistry(EntityRegistry&&) noexcept = default;
+	~EntityRegistry() = default;
+
+	EntityRegistry& operator= (EntityRegistry&&) noexcept = default;
+
+	EntityRegistry(const EntityRegistry&) = delete;
+	EntityRegistry& operator= (const EntityRegistry&) = delete;
+
+public:
+	Entity create(UniqueId uid = UniqueId::make());
+
+	template<typename... _Tys>
+	Entity create(UniqueId uid, _Tys&&... components)
+	{
+		Entity entity = create(uid);
+		if (entity)
+			(addComponent<std::remove_cvref_t<_Tys>>(entity, std::forward<_Tys>(components)), ...);
+		return entity;
+	}
+
+	bool destroy(Entity entity);
+	inline bool destroy(UniqueId uid) { return destroy(findByUid(uid)); }
+
+	inline bool alive(Entity entity) const { return _records.contains(entity); }
+	inline Size size() const { return _records.size(); }
+
+	Entity findByUid(UniqueId uid) const;
+	inline UniqueId uid(Entity entity) const { return alive(entity) ? _records[entity].uid : UniqueId{}; }
+
+	/* Returns nullptr for dead entities. An existing component is reassigned from args, or left unchanged when none are given */
+	template<typename _Ty, typename... _Args>
+	_Ty* addComponent(Entity entity, _Args&&... args)
+	{
+		const ComponentType& type = ComponentType::of<_Ty>();
+		if (!alive(entity))
+			return nullptr;
+
+		Record& record = _records[entity];
+		if (record.archetype->_mask & type.mask())
+		{
+			_Ty* component = reinterpret_cast<_Ty*>(record.archetype->column(type.id())->at(record.row));
+			if constexpr (sizeof...(_Args) > 0)
+				*component = _Ty(std::forward<_Args>(args)...);
+			return component;
+		}
+
+		Archetype* dst = _nextArchetype(*record.archetype, type, true);
+		_migrate(record, *dst);
+		return new (dst->column(type.id())->pushUninitialized()) _Ty(std::forward<_Args>(args)...);
+	}
+
+	template<typename _Ty>
+	bool removeComponent(Entity entity)
+	{
+		const ComponentType& type = ComponentType::of<_Ty>();
+		if (!alive(entity))
+			return false;
+
+		Record& record = _records[entity];
+		if (!(record.archetype->_mask & type.mask()))
+			return false;
+
+		_migrate(record, *_nextArchetype(*record.archetype, type, false));
+		return true;
+	}
+
+	template<typename _Ty>
+	_Ty* getComponent(Entity entity)
+	{
+		if (!alive(entity))
+			return nullptr;
+
+		const Record& record = _records[entity];
+		ComponentColumn* column = record.archetype->column(ComponentType::of<_Ty>().id());
+		return column ? reinterpret_cast<_Ty*>(column->at(record.row)) : nullptr;
+	}
+
+	template<typename _Ty>
+	inline bool hasComponent(Entity entity) const
+	{
+		return alive(entity) && (_records[entity].archetype->_mask & ComponentType::of<_Ty>().mask());
+	}
+
+	template<typename... _Tys, typename _Fty>
+	void each(_Fty&& action)
+	{
+		for (Archetype* archetype : archetypesMatching(ComponentType::maskOf<_Tys...>()))
+		{
+			Size count = archetype->size();
+			if (count == 0)
+				continue;
+
+			std::tuple<_Tys*...> columns{ archetype->columnData<_Tys>()... };
+			for (Size row = 0; row < count; ++row)
+			{
+				if constexpr (std::invocable<_Fty&, Entity, _Tys&...>)
+					action(archetype->entityAt(row), std::get<_Tys*>(columns)[row]...);
+				else action(std::get<_Tys*>(columns)[row]...);
+			}
+		}
+	}
+
+	const std::vector<Archetype*>& archetypesMatching(ComponentMask required);
+
+	inline Size archetypeCount() const { return _archetypes.size(); }
+
+private:
+	Archetype& _archetypeOf(ComponentMask mask);
+	Archetype* _nextArchetype(Archetype& src, const ComponentType& type, bool add);
+	void _migrate(Record& record, Archetype& dst);
+	void _fixupMoved(Entity moved, Size row);
+};
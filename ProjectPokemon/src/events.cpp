@@ -0,0 +1,302 @@
+#include "events.h"
+#include "game_basics.h"
+
+namespace
+{
+	inline UInt32 key_index(sf::Event::EventType type, sf::Keyboard::Key key)
+	{
+		return static_cast<UInt32>(type) * sf::Keyboard::KeyCount + static_cast<UInt32>(key);
+	}
+
+	inline Size ceil_pow2(Size value)
+	{
+		Size result = 1;
+		while (result < value)
+			result <<= 1;
+		return result;
+	}
+}
+
+EventQueue::EventQueue(Size capacity) :
+	_events(ceil_pow2(std::max<Size>(capacity, 2)))
+{}
+
+void EventQueue::push(const sf::Event& event)
+{
+	if (event.type == sf::Event::MouseMoved && _size > 0)
+	{
+		sf::Event& last = _at(_size - 1);
+		if (last.type == sf::Event::MouseMoved)
+		{
+			last = event;
+			return;
+		}
+	}
+
+	if (_size == _events.size())
+	{
+		_head = (_head + 1) & (_events.size() - 1);
+		--_size;
+		++_dropped;
+	}
+
+	_at(_size++) = event;
+}
+
+bool EventQueue::pop(sf::Event& event)
+{
+	if (_size == 0)
+		return false;
+
+	event = _at(0);
+	_head = (_head + 1) & (_events.size() - 1);
+	--_size;
+	return true;
+}
+
+
+
+EventRouter::EventRouter(Size queueCapacity) :
+	_queue{ queueCapacity }
+{}
+
+SlotHandle EventRouter::subscribe(const EventFilter& filter, Handler handler)
+{
+	SlotHandle subscription = _subs.insert({ filter, std::make_unique<Handler>(std::move(handler)), true, {} });
+	if (_routing > 0)
+		_pending.push_back(subscription);
+	else _insert(subscription);
+	return subscription;
+}
+
+bool EventRouter::unsubscribe(SlotHandle subscription)
+{
+	if (!isSubscribed(subscription))
+		return false;
+
+	if (_capture == subscription)
+		_capture = {};
+	std::erase(_focusChain, subscription);
+
+	if (UniqueId owner = _subs[subscription].owner)
+	{
+		auto it = _byOwner.find(owner);
+		if (it != _byOwner.end() && erase(it->second, subscription) > 0 && it->second.empty())
+			_byOwner.erase(owner);
+	}
+
+	if (_routing > 0)
+	{
+		_subs[subscription].active = false;
+		_removed.push_back(subscription);
+		return true;
+	}
+
+	erase(_listOf(_subs[subscription].filter), subscription);
+	return _subs.erase(subscription);
+}
+
+Size EventRouter::unsubscribeOwner(UniqueId owner)
+{
+	auto it = _byOwner.find(owner);
+	if (it == _byOwner.end())
+		return 0;
+
+	SubscriptionList owned = std::move(it->second);
+	_byOwner.erase(owner);
+	for (SlotHandle subscription : owned)
+	{
+		_subs[subscription].owner = {};
+		unsubscribe(subscription);
+	}
+	return owned.size();
+}
+
+void EventRouter::unsubscribeOwned()
+{
+	std::vector<UniqueId> owners;
+	owners.reserve(_byOwner.size());
+	for (const auto& entry : _byOwner)
+		owners.push_back(entry.first);
+
+	for (UniqueId owner : owners)
+		unsubscribeOwner(owner);
+}
+
+void EventRouter::pushFocus(SlotHandle subscription)
+{
+	std::erase(_focusChain, subscription);
+	_focusChain.push_back(subscription);
+}
+
+void EventRouter::popFocus()
+{
+	if (!_focusChain.empty())
+		_focusChain.pop_back();
+}
+
+bool EventRouter::removeFocus(SlotHandle subscription)
+{
+	return std::erase(_focusChain, subscription) > 0;
+}
+
+void EventRouter::dispatch()
+{
+	sf::Event event;
+	while (_queue.pop(event))
+		route(event);
+}
+
+bool EventRouter::route(const sf::Event& event)
+{
+	std::optional<Vec2f> point = pointOf(event);
+	bool consumed = false;
+	SubscriptionList delivered;
+
+	++_routing;
+	if (_capture && isMouseEvent(event.type))
+	{
+		consumed = _deliver(_capture, event, std::nullopt);
+		delivered.push_back(_capture);
+	}
+
+	if (!consumed && isKeyboardEvent(event.type))
+	{
+		for (Size i = _focusChain.size(); i > 0 && !consumed; --i)
+		{
+			const Subscription* sub = _subs.get(_focusChain[i - 1]);
+			if (sub && sub->filter.type == event.type)
+			{
+				consumed = _deliver(_focusChain[i - 1], event, std::nullopt);
+				delivered.push_back(_focusChain[i - 1]);
+			}
+		}
+	}
+
+	if (!consumed && (event.type == sf::Event::KeyPressed || event.type == sf::Event::KeyReleased) && event.key.code != sf::Keyboard::Unknown)
+	{
+		auto it = _byKey.find(key_index(event.type, event.key.code));
+		if (it != _byKey.end())
+			consumed = _deliverAll(it->second, event, point, delivered);
+	}
+
+	if (!consumed)
+		consumed = _deliverAll(_byType[event.type], event, point, delivered);
+	--_routing;
+
+	if (_routing == 0)
+		_flushChanges();
+
+	return consumed;
+}
+
+bool EventRouter::isMouseEvent(sf::Event::EventType type)
+{
+	switch (type)
+	{
+		case sf::Event::MouseWheelMoved:
+		case sf::Event::MouseWheelScrolled:
+		case sf::Event::MouseButtonPressed:
+		case sf::Event::MouseButtonReleased:
+		case sf::Event::MouseMoved:
+		case sf::Event::MouseEntered:
+		case sf::Event::MouseLeft:
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+bool EventRouter::isKeyboardEvent(sf::Event::EventType type)
+{
+	return type == sf::Event::KeyPressed || type == sf::Event::KeyReleased || type == sf::Event::TextEntered;
+}
+
+std::optional<Vec2f> EventRouter::pointOf(const sf::Event& event)
+{
+	switch (event.type)
+	{
+		case sf::Event::MouseWheelMoved:
+			return Vec2f{ static_cast<float>(event.mouseWheel.x), static_cast<float>(event.mouseWheel.y) };
+
+		case sf::Event::MouseWheelScrolled:
+			return Vec2f{ static_cast<float>(event.mouseWheelScroll.x), static_cast<float>(event.mouseWheelScroll.y) };
+
+		case sf::Event::MouseButtonPressed:
+		case sf::Event::MouseButtonReleased:
+			return Vec2f{ static_cast<float>(event.mouseButton.x), static_cast<float>(event.mouseButton.y) };
+
+		case sf::Event::MouseMoved:
+			return Vec2f{ static_cast<float>(event.mouseMove.x), static_cast<float>(event.mouseMove.y) };
+
+		case sf::Event::TouchBegan:
+		case sf::Event::TouchMoved:
+		case sf::Event::TouchEnded:
+			return Vec2f{ static_cast<float>(event.touch.x), static_cast<float>(event.touch.y) };
+
+		default:
+			return std::nullopt;
+	}
+}
+
+EventRouter::SubscriptionList& EventRouter::_listOf(const EventFilter& filter)
+{
+	if ((filter.type == sf::Event::KeyPressed || filter.type == sf::Event::KeyReleased) && filter.key != sf::Keyboard::Unknown)
+		return _byKey[key_index(filter.type, filter.key)];
+	return _byType[filter.type];
+}
+
+void EventRouter::_insert(SlotHandle subscription)
+{
+	auto& list = _listOf(_subs[subscription].filter);
+	Int32 priority = _subs[subscription].filter.priority;
+	auto it = std::upper_bound(list.begin(), list.end(), priority, [this](Int32 value, SlotHandle other) {
+		return value > _subs[other].filter.priority;
+	});
+	list.insert(it, subscription);
+}
+
+void EventRouter::_own(SlotHandle subscription, UniqueId owner)
+{
+	_subs[subscription].owner = owner;
+	_byOwner[owner].push_back(subscription);
+}
+
+void EventRouter::_flushChanges()
+{
+	for (SlotHandle subscription : _removed)
+	{
+		erase(_listOf(_subs[subscription].filter), subscription);
+		std::erase(_pending, subscription);
+		_subs.erase(subscription);
+	}
+	_removed.clear();
+
+	for (SlotHandle subscription : _pending)
+		_insert(subscription);
+	_pending.clear();
+}
+
+bool EventRouter::_deliver(SlotHandle subscription, const sf::Event& event, const std::optional<Vec2f>& point)
+{
+	Subscription* sub = _subs.get(subscription);
+	if (!sub || !sub->active)
+		return false;
+
+	if (point && sub->filter.region && !sub->filter.region->contains(*point))
+		return false;
+
+	++_delivered;
+	Handler& handler = *sub->handler;
+	return handler(event);
+}
+
+bool EventRouter::_deliverAll(SubscriptionList& list, const sf::Event& event, const std::optional<Vec2f>& point, const SubscriptionList& skip)
+{
+	// Capture and focus deliveries are not repeated when they left the event unconsumed
+	for (Size i = 0; i < list.size(); ++i)
+		if (std::find(skip.begin(), skip.end(), list[i]) == skip.end() && _deliver(list[i], event, point))
+			return true;
+	return false;
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "common.h"
+#include "slot_map.h"
+#include "small_vector.h"
+
+class GameObject;
+
+template<std::derived_from<GameObject> _Ty>
+class GameObjectContainer;
+
+class EventQueue
+{
+private:
+	std::vector<sf::Event> _events;
+	Size _head = 0;
+	Size _size = 0;
+	Size _dropped = 0;
+
+public:
+	explicit EventQueue(Size capacity = 256);
+	EventQueue(const EventQueue&) = default;
+	EventQueue(EventQueue&&) noexcept = default;
+	~EventQueue() = default;
+
+	EventQueue& operator= (const EventQueue&) = default;
+	EventQueue& operator= (EventQueue&&) noexcept = default;
+
+	inline Size size() const { return _size; }
+	inline bool empty() const { return _size == 0; }
+	inline Size capacity() const { return _events.size(); }
+	inline Size dropped() const { return _dropped; }
+
+	void push(const sf::Event& event);
+	bool pop(sf::Event& event);
+	inline void clear() { _head = 0, _size = 0; }
+
+private:
+	inline sf::Event& _at(Size index) { return _events[(_head + index) & (_events.size() - 1)]; }
+};
+
+
+
+struct EventFilter
+{
+	sf::Event::EventType type;
+	sf::Keyboard::Key key = sf::Keyboard::Unknown;
+	std::optional<sf::FloatRect> region;
+	Int32 priority = 0;
+
+	static inline EventFilter of(sf::Event::EventType type, Int32 priority = 0) { return { type, sf::Keyboard::Unknown, std::nullopt, priority }; }
+	static inline EventFilter keyOf(sf::Event::EventType type, sf::Keyboard::Key key, Int32 priority = 0) { return { type, key, std::nullopt, priority }; }
+	static inline EventFilter regionOf(sf::Event::EventType type, const sf::FloatRect& region, Int32 priority = 0) { return { type, sf::Keyboard::Unknown, region, priority }; }
+};
+
+
+
+class EventRouter
+{
+public:
+	typedef Function<bool(const sf::Event&)> Handler;
+	typedef SmallVector<SlotHandle, 4> SubscriptionList;
+
+private:
+	struct Subscription
+	{
+		EventFilter filter;
+		uref<Handler> handler;
+		bool active;
+		UniqueId owner;
+	};
+
+	SlotMap<Subscription> _subs;
+	std::array<SubscriptionList, sf::Event::Count> _byType;
+	std::unordered_map<UInt32, SubscriptionList> _byKey;
+	FlatHashMap<UniqueId, SubscriptionList, UniqueId::hash> _byOwner;
+	std::vector<SlotHandle> _focusChain;
+	std::vector<SlotHandle> _pending;
+	std::vector<SlotHandle> _removed;
+	SlotHandle _capture;
+	EventQueue _queue;
+	Size _delivered = 0;
+	UInt32 _routing = 0;
+
+public:
+	explicit EventRouter(Size queueCapacity = 256);
+	EventRouter(EventRouter&&) noexcept = default;
+	~EventRouter() = default;
+
+	EventRouter& operator= (EventRouter&&) noexcept = default;
+
+	EventRouter(const EventRouter&) = delete;
+	EventRouter& operator= (const EventRouter&) = delete;
+
+public:
+	SlotHandle subscribe(const EventFilter& filter, Handler handler);
+	bool unsubscribe(SlotHandle subscription);
+
+	/*
+	 * Routes events to an object's dispatchEvent hook. The object is resolved
+	 * through its container on every delivery, since its storage moves; the
+	 * subscription is owned by the object and unsubscribeOwner() drops it.
+	 */
+	template<std::derived_from<GameObject> _Ty>
+	SlotHandle subscribe(const EventFilter& filter, GameObjectContainer<_Ty>& container, SlotHandle object)
+	{
+		const _Ty* obj = container.getGameObject(object);
+		if (!obj)
+			return {};
+
+		SlotHandle subscription = subscribe(filter, [&container, object](const sf::Event& event) {
+			_Ty* target = container.getGameObject(object);
+			return target && target->dispatchEvent(event);
+		});
+		_own(subscription, obj->uid());
+		return subscription;
+	}
+
+	Size unsubscribeOwner(UniqueId owner);
+	void unsubscribeOwned();
+
+	inline bool isSubscribed(SlotHandle subscription) const { return _subs.contains(subscription) && _subs[subscription].active; }
+	inline Size subscriptionCount() const { return _subs.size() - _removed.size(); }
+
+	void pushFocus(SlotHandle subscription);
+	void popFocus();
+	bool removeFocus(SlotHandle subscription);
+	inline SlotHandle focused() const { return _focusChain.empty() ? SlotHandle{} : _focusChain.back(); }
+
+	inline void capture(SlotHandle subscription) { _capture = subscription; }
+	inline void releaseCapture() { _capture = {}; }
+	inline SlotHandle captured() const { return _capture; }
+
+	inline void post(const sf::Event& event) { _queue.push(event); }
+	void dispatch();
+	bool route(const sf::Event& event);
+
+	inline const EventQueue& queue() const { return _queue; }
+	inline Size deliveredCount() const { return _delivered; }
+
+	static bool isMouseEvent(sf::Event::EventType type);
+	static bool isKeyboardEvent(sf::Event::EventType type);
+	static std::optional<Vec2f> pointOf(const sf::Event& event);
+
+private:
+	SubscriptionList& _listOf(const EventFilter& filter);
+	void _insert(SlotHandle subscription);
+	void _own(SlotHandle subscription, UniqueId owner);
+	void _flushChanges();
+	bool _deliver(SlotHandle subscription, const sf::Event& event, const std::optional<Vec2f>& point);
+	bool _deliverAll(SubscriptionList& list, const sf::Event& event, const std::optional<Vec2f>& point, const SubscriptionList& skip);
+};
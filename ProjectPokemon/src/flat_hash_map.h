@@ -0,0 +1,528 @@
+#pragma once
+
+#include "common.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define FLAT_HASH_MAP_SSE2
+#	include <emmintrin.h>
+#endif
+
+namespace utils::flat_hash
+{
+	typedef Int8 Ctrl;
+
+	constexpr Ctrl ctrl_empty = -128;
+	constexpr Ctrl ctrl_deleted = -2;
+
+#ifdef FLAT_HASH_MAP_SSE2
+	struct Group
+	{
+		static constexpr Size width = 16;
+		static constexpr UInt32 shift = 0;
+
+		__m128i ctrl;
+
+		explicit inline Group(const Ctrl* pos) : ctrl{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos)) } {}
+
+		inline UInt32 match(Ctrl h2) const { return static_cast<UInt32>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl))); }
+		inline UInt32 matchEmpty() const { return static_cast<UInt32>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(ctrl_empty), ctrl))); }
+		inline UInt32 matchFree() const { return static_cast<UInt32>(_mm_movemask_epi8(ctrl)); }
+	};
+#else
+	struct Group
+	{
+		static constexpr Size width = 8;
+		static constexpr UInt32 shift = 3;
+		static constexpr UInt64 lsbs = 0x0101010101010101ULL;
+		static constexpr UInt64 msbs = 0x8080808080808080ULL;
+
+		UInt64 ctrl;
+
+		explicit inline Group(const Ctrl* pos) { std::memcpy(&ctrl, pos, sizeof(ctrl)); }
+
+		inline UInt64 match(Ctrl h2) const
+		{
+			UInt64 bytes = ctrl ^ (lsbs * static_cast<UInt8>(h2));
+			return (bytes - lsbs) & ~bytes & msbs;
+		}
+
+		inline UInt64 matchEmpty() const { return ctrl & (~ctrl << 6) & msbs; }
+		inline UInt64 matchFree() const { return ctrl & msbs; }
+	};
+#endif
+
+	template<typename _MaskTy>
+	inline Size lowest(_MaskTy mask) { return static_cast<Size>(std::countr_zero(mask)) >> Group::shift; }
+}
+
+/*
+ * Open addressing hash map in the Swiss table layout: one control byte per
+ * slot holding 7 bits of the hash (or an empty/deleted marker), probed a whole
+ * group at a time. The first group of control bytes is mirrored after the
+ * last one so a group load never has to wrap. Keys are rehashed through
+ * utils::mix_bits, so identity hashes are fine. Lookups with other key types
+ * are enabled when both the hasher and the key equality are transparent.
+ * Storage comes from a std::pmr::memory_resource; copies use the default
+ * resource and moves carry the source's resource along.
+ */
+template<typename _KeyTy, typename _ValueTy, typename _HashTy = std::hash<_KeyTy>, typename _EqualTy = std::equal_to<_KeyTy>>
+class FlatHashMap
+{
+public:
+	using key_type = _KeyTy;
+	using mapped_type = _ValueTy;
+	using value_type = std::pair<_KeyTy, _ValueTy>;
+	using size_type = Size;
+	using hasher = _HashTy;
+	using key_equal = _EqualTy;
+
+	static constexpr Size min_capacity = 16;
+
+private:
+	static constexpr Size block_alignment = std::max(alignof(value_type), alignof(std::max_align_t));
+
+	using Ctrl = utils::flat_hash::Ctrl;
+	using Group = utils::flat_hash::Group;
+
+	static constexpr Size npos = ~Size(0);
+
+	template<typename _LookupTy>
+	static constexpr bool is_lookup_key = std::same_as<_LookupTy, _KeyTy> || requires { typename _HashTy::is_transparent; typename _EqualTy::is_transparent; };
+
+public:
+	template<bool _Const>
+	class basic_iterator
+	{
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = FlatHashMap::value_type;
+		using difference_type = std::ptrdiff_t;
+		using pointer = std::conditional_t<_Const, const value_type*, value_type*>;
+		using reference = std::conditional_t<_Const, const value_type&, value_type&>;
+
+	private:
+		const Ctrl* _ctrl = nullptr;
+		const Ctrl* _end = nullptr;
+		pointer _slot = nullptr;
+
+	public:
+		basic_iterator() = default;
+		basic_iterator(const basic_iterator&) = default;
+		~basic_iterator() = default;
+
+		basic_iterator& operator= (const basic_iterator&) = default;
+
+		template<bool _OtherConst> requires (_Const && !_OtherConst)
+		inline basic_iterator(const basic_iterator<_OtherConst>& other) : _ctrl{ other._ctrl }, _end{ other._end }, _slot{ other._slot } {}
+
+		inline reference operator* () const { return *_slot; }
+		inline pointer operator-> () const { return _slot; }
+
+		inline basic_iterator& operator++ () { return ++_ctrl, ++_slot, _skip(), *this; }
+		inline basic_iterator operator++ (int) { basic_iterator copy = *this; return ++*this, copy; }
+
+		template<bool _OtherConst>
+		inline bool operator== (const basic_iterator<_OtherConst>& right) const { return _ctrl == right._ctrl; }
+
+	private:
+		inline basic_iterator(const Ctrl* ctrl, const Ctrl* end, pointer slot) : _ctrl{ ctrl }, _end{ end }, _slot{ slot } { _skip(); }
+
+		inline void _skip()
+		{
+			while (_ctrl != _end && *_ctrl < 0)
+				++_ctrl, ++_slot;
+		}
+
+	public:
+		friend class FlatHashMap;
+
+		template<bool>
+		friend class basic_iterator;
+	};
+
+	using iterator = basic_iterator<false>;
+	using const_iterator = basic_iterator<true>;
+
+private:
+	Ctrl* _ctrl = nullptr;
+	value_type* _slots = nullptr;
+	Size _capacity = 0;
+	Size _size = 0;
+	Size _growthLeft = 0;
+	_HashTy _hash;
+	_EqualTy _equal;
+	std::pmr::memory_resource* _resource = std::pmr::get_default_resource();
+
+public:
+	FlatHashMap() = default;
+
+	explicit FlatHashMap(std::pmr::memory_resource* resource) : _resource{ resource } {}
+
+	explicit FlatHashMap(Size capacity, const _HashTy& hash = _HashTy(), const _EqualTy& equal = _EqualTy(), std::pmr::memory_resource* resource = std::pmr::get_default_resource()) :
+		_hash{ hash },
+		_equal{ equal },
+		_resource{ resource }
+	{
+		reserve(capacity);
+	}
+
+	FlatHashMap(std::initializer_list<value_type> values) : FlatHashMap(values.size())
+	{
+		for (const value_type& value : values)
+			insert(value);
+	}
+
+	FlatHashMap(const FlatHashMap& other, std::pmr::memory_resource* resource = std::pmr::get_default_resource()) :
+		_hash{ other._hash },
+		_equal{ other._equal },
+		_resource{ resource }
+	{
+		_copyFrom(other);
+	}
+
+	FlatHashMap(FlatHashMap&& other) noexcept :
+		_ctrl{ std::exchange(other._ctrl, nullptr) },
+		_slots{ std::exchange(other._slots, nullptr) },
+		_capacity{ std::exchange(other._capacity, 0) },
+		_size{ std::exchange(other._size, 0) },
+		_growthLeft{ std::exchange(other._growthLeft, 0) },
+		_hash{ std::move(other._hash) },
+		_equal{ std::move(other._equal) },
+		_resource{ other._resource }
+	{}
+
+	~FlatHashMap() { _destroy(); }
+
+	FlatHashMap& operator= (const FlatHashMap& right)
+	{
+		if (this != &right)
+		{
+			FlatHashMap copy{ right, _resource };
+			swap(copy);
+		}
+		return *this;
+	}
+
+	FlatHashMap& operator= (FlatHashMap&& right) noexcept
+	{
+		if (this != &right)
+		{
+			_destroy();
+			_ctrl = std::exchange(right._ctrl, nullptr);
+			_slots = std::exchange(right._slots, nullptr);
+			_capacity = std::exchange(right._capacity, 0);
+			_size = std::exchange(right._size, 0);
+			_growthLeft = std::exchange(right._growthLeft, 0);
+			_hash = std::move(right._hash);
+			_equal = std::move(right._equal);
+			_resource = right._resource;
+		}
+		return *this;
+	}
+
+public:
+	inline Size size() const { return _size; }
+	inline bool empty() const { return _size == 0; }
+	inline Size capacity() const { return _capacity; }
+	inline float load_factor() const { return _capacity ? static_cast<float>(_size) / static_cast<float>(_capacity) : 0.f; }
+	static constexpr float max_load_factor() { return 7.f / 8.f; }
+
+	inline hasher hash_function() const { return _hash; }
+	inline key_equal key_eq() const { return _equal; }
+	inline std::pmr::memory_resource* resource() const { return _resource; }
+
+	inline iterator begin() { return { _ctrl, _ctrl + _capacity, _slots }; }
+	inline const_iterator begin() const { return { _ctrl, _ctrl + _capacity, _slots }; }
+	inline const_iterator cbegin() const { return begin(); }
+
+	inline iterator end() { return { _ctrl + _capacity, _ctrl + _capacity, _slots + _capacity }; }
+	inline const_iterator end() const { return { _ctrl + _capacity, _ctrl + _capacity, _slots + _capacity }; }
+	inline const_iterator cend() const { return end(); }
+
+	void reserve(Size count)
+	{
+		Size needed = _capacityFor(count);
+		if (needed > _capacity)
+			_rehash(needed);
+	}
+
+	void rehash(Size capacity)
+	{
+		capacity = std::max(_capacityFor(_size), capacity ? std::bit_ceil(std::max(capacity, min_capacity)) : 0);
+		if (capacity == 0)
+			_destroy();
+		else if (capacity != _capacity || _growthLeft < _maxLoad(_capacity) - _size)
+			_rehash(capacity);
+	}
+
+	void clear()
+	{
+		if (_size == 0)
+			return;
+
+		for (Size i = 0; i < _capacity; ++i)
+			if (_ctrl[i] >= 0)
+				utils::destroy(_slots[i]);
+
+		std::memset(_ctrl, utils::flat_hash::ctrl_empty, _capacity + Group::width);
+		_size = 0;
+		_growthLeft = _maxLoad(_capacity);
+	}
+
+	void swap(FlatHashMap& other) noexcept
+	{
+		std::swap(_ctrl, other._ctrl);
+		std::swap(_slots, other._slots);
+		std::swap(_capacity, other._capacity);
+		std::swap(_size, other._size);
+		std::swap(_growthLeft, other._growthLeft);
+		std::swap(_hash, other._hash);
+		std::swap(_equal, other._equal);
+		std::swap(_resource, other._resource);
+	}
+
+	template<typename _LookupTy> requires is_lookup_key<_LookupTy>
+	inline iterator find(const _LookupTy& key) { return _iteratorAt(_find(key, _hashOf(key))); }
+
+	template<typename _LookupTy> requires is_lookup_key<_LookupTy>
+	inline const_iterator find(const _LookupTy& key) const { return _iteratorAt(_find(key, _hashOf(key))); }
+
+	inline iterator find(const _KeyTy& key) { return _iteratorAt(_find(key, _hashOf(key))); }
+	inline const_iterator find(const _KeyTy& key) const { return _iteratorAt(_find(key, _hashOf(key))); }
+
+	template<typename _LookupTy> requires is_lookup_key<_LookupTy>
+	inline bool contains(const _LookupTy& key) const { return _find(key, _hashOf(key)) != npos; }
+
+	inline bool contains(const _KeyTy& key) const { return _find(key, _hashOf(key)) != npos; }
+
+	template<typename _LookupTy> requires is_lookup_key<_LookupTy>
+	inline Size count(const _LookupTy& key) const { return contains(key) ? 1 : 0; }
+
+	inline Size count(const _KeyTy& key) const { return contains(key) ? 1 : 0; }
+
+	template<typename _LookupTy> requires is_lookup_key<_LookupTy>
+	_ValueTy& at(const _LookupTy& key)
+	{
+		Size index = _find(key, _hashOf(key));
+		if (index == npos)
+			throw std::out_of_range("FlatHashMap::at: key not found");
+		return _slots[index].second;
+	}
+
+	template<typename _LookupTy> requires is_lookup_key<_LookupTy>
+	const _ValueTy& at(const _LookupTy& key) const { return const_cast<FlatHashMap*>(this)->at(key); }
+
+	inline _ValueTy& operator[] (const _KeyTy& key) { return try_emplace(key).first->second; }
+	inline _ValueTy& operator[] (_KeyTy&& key) { return try_emplace(std::move(key)).first->second; }
+
+	template<typename... _Args>
+	inline std::pair<iterator, bool> try_emplace(const _KeyTy& key, _Args&&... args) { return _tryEmplace(key, std::forward<_Args>(args)...); }
+
+	template<typename... _Args>
+	inline std::pair<iterator, bool> try_emplace(_KeyTy&& key, _Args&&... args) { return _tryEmplace(std::move(key), std::forward<_Args>(args)...); }
+
+	template<typename _KeyArgTy, typename... _Args>
+	inline std::pair<iterator, bool> emplace(_KeyArgTy&& key, _Args&&... args) { return _tryEmplace(std::forward<_KeyArgTy>(key), std::forward<_Args>(args)...); }
+
+	inline std::pair<iterator, bool> insert(const value_type& value) { return _tryEmplace(value.first, value.second); }
+	inline std::pair<iterator, bool> insert(value_type&& value) { return _tryEmplace(std::move(value.first), std::move(value.second)); }
+
+	template<typename _MappedTy>
+	std::pair<iterator, bool> insert_or_assign(const _KeyTy& key, _MappedTy&& value)
+	{
+		auto result = _tryEmplace(key, std::forward<_MappedTy>(value));
+		if (!result.second)
+			result.first->second = std::forward<_MappedTy>(value);
+		return result;
+	}
+
+	template<typename _LookupTy> requires is_lookup_key<_LookupTy>
+	Size erase(const _LookupTy& key)
+	{
+		Size index = _find(key, _hashOf(key));
+		if (index == npos)
+			return 0;
+
+		_eraseAt(index);
+		return 1;
+	}
+
+	inline Size erase(const _KeyTy& key) { return erase<_KeyTy>(key); }
+
+	iterator erase(const_iterator pos)
+	{
+		Size index = static_cast<Size>(pos._ctrl - _ctrl);
+		_eraseAt(index);
+		return { _ctrl + index + 1, _ctrl + _capacity, _slots + index + 1 };
+	}
+
+	inline iterator erase(iterator pos) { return erase(const_iterator{ pos }); }
+
+	friend inline void swap(FlatHashMap& left, FlatHashMap& right) noexcept { left.swap(right); }
+
+private:
+	static constexpr Size _maxLoad(Size capacity) { return capacity - capacity / 8; }
+
+	static constexpr Size _capacityFor(Size count)
+	{
+		if (count == 0)
+			return 0;
+
+		Size capacity = min_capacity;
+		while (_maxLoad(capacity) < count)
+			capacity <<= 1;
+		return capacity;
+	}
+
+	static constexpr Size _slotsOffset(Size capacity)
+	{
+		return (capacity + Group::width + alignof(value_type) - 1) & ~(alignof(value_type) - 1);
+	}
+
+	static constexpr Size _blockSize(Size capacity) { return _slotsOffset(capacity) + capacity * sizeof(value_type); }
+
+	template<typename _LookupTy>
+	inline Size _hashOf(const _LookupTy& key) const { return static_cast<Size>(utils::mix_bits(static_cast<UInt64>(_hash(key)))); }
+
+	static inline Ctrl _h2(Size hash) { return static_cast<Ctrl>(hash & 0x7F); }
+
+	inline iterator _iteratorAt(Size index) { return index == npos ? end() : iterator{ _ctrl + index, _ctrl + _capacity, _slots + index }; }
+	inline const_iterator _iteratorAt(Size index) const { return index == npos ? end() : const_iterator{ _ctrl + index, _ctrl + _capacity, _slots + index }; }
+
+	template<typename _LookupTy>
+	Size _find(const _LookupTy& key, Size hash) const
+	{
+		if (_size == 0)
+			return npos;
+
+		Size mask = _capacity - 1;
+		Size pos = (hash >> 7) & mask;
+		for (Size step = Group::width;; step += Group::width)
+		{
+			Group group{ _ctrl + pos };
+			for (auto bits = group.match(_h2(hash)); bits; bits &= bits - 1)
+			{
+				Size index = (pos + utils::flat_hash::lowest(bits)) & mask;
+				if (_equal(_slots[index].first, key))
+					return index;
+			}
+
+			if (group.matchEmpty())
+				return npos;
+			pos = (pos + step) & mask;
+		}
+	}
+
+	Size _findFree(Size hash) const
+	{
+		Size mask = _capacity - 1;
+		Size pos = (hash >> 7) & mask;
+		for (Size step = Group::width;; step += Group::width)
+		{
+			auto bits = Group{ _ctrl + pos }.matchFree();
+			if (bits)
+				return (pos + utils::flat_hash::lowest(bits)) & mask;
+			pos = (pos + step) & mask;
+		}
+	}
+
+	inline void _setCtrl(Size index, Ctrl value)
+	{
+		_ctrl[index] = value;
+		if (index < Group::width)
+			_ctrl[_capacity + index] = value;
+	}
+
+	template<typename _KeyArgTy, typename... _Args>
+	std::pair<iterator, bool> _tryEmplace(_KeyArgTy&& key, _Args&&... args)
+	{
+		Size hash = _hashOf(key);
+		Size index = _find(key, hash);
+		if (index != npos)
+			return { _iteratorAt(index), false };
+
+		if (_growthLeft == 0)
+			_rehash(_capacity == 0 ? min_capacity : (_size >= _maxLoad(_capacity) / 2 ? _capacity * 2 : _capacity));
+
+		index = _findFree(hash);
+		new (_slots + index) value_type(std::piecewise_construct,
+			std::forward_as_tuple(std::forward<_KeyArgTy>(key)),
+			std::forward_as_tuple(std::forward<_Args>(args)...));
+
+		if (_ctrl[index] == utils::flat_hash::ctrl_empty)
+			--_growthLeft;
+		_setCtrl(index, _h2(hash));
+		++_size;
+		return { _iteratorAt(index), true };
+	}
+
+	void _eraseAt(Size index)
+	{
+		utils::destroy(_slots[index]);
+		_setCtrl(index, utils::flat_hash::ctrl_deleted);
+		--_size;
+	}
+
+	void _rehash(Size capacity)
+	{
+		char* block = static_cast<char*>(_resource->allocate(_blockSize(capacity), block_alignment));
+		Ctrl* ctrl = reinterpret_cast<Ctrl*>(block);
+		value_type* slots = reinterpret_cast<value_type*>(block + _slotsOffset(capacity));
+		std::memset(ctrl, utils::flat_hash::ctrl_empty, capacity + Group::width);
+
+		Ctrl* oldCtrl = std::exchange(_ctrl, ctrl);
+		value_type* oldSlots = std::exchange(_slots, slots);
+		Size oldCapacity = std::exchange(_capacity, capacity);
+
+		for (Size i = 0; i < oldCapacity; ++i)
+		{
+			if (oldCtrl[i] < 0)
+				continue;
+
+			Size hash = _hashOf(oldSlots[i].first);
+			Size index = _findFree(hash);
+			new (_slots + index) value_type(std::move(oldSlots[i]));
+			utils::destroy(oldSlots[i]);
+			_setCtrl(index, _h2(hash));
+		}
+
+		_growthLeft = _maxLoad(capacity) - _size;
+		if (oldCtrl)
+			_resource->deallocate(oldCtrl, _blockSize(oldCapacity), block_alignment);
+	}
+
+	void _copyFrom(const FlatHashMap& other)
+	{
+		if (other._size == 0)
+			return;
+
+		_rehash(other._capacity);
+		for (Size i = 0; i < other._capacity; ++i)
+		{
+			if (other._ctrl[i] >= 0)
+			{
+				new (_slots + i) value_type(other._slots[i]);
+				_setCtrl(i, other._ctrl[i]);
+				++_size;
+			}
+		}
+
+		std::memcpy(_ctrl, other._ctrl, _capacity + Group::width);
+		_growthLeft = other._growthLeft;
+	}
+
+	void _destroy()
+	{
+		if (!_ctrl)
+			return;
+
+		for (Size i = 0; i < _capacity; ++i)
+			if (_ctrl[i] >= 0)
+				utils::destroy(_slots[i]);
+
+		_resource->deallocate(_ctrl, _blockSize(_capacity), block_alignment);
+		_ctrl = nullptr;
+		_slots = nullptr;
+		_capacity = _size = _growthLeft = 0;
+	}
+};
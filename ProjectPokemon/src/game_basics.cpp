@@ -1,3 +1,294 @@
 #include "game_basics.h"
 
+namespace
+{
+	// A batch-only type hides GameObject::render(sf::RenderTarget&, float); its bucket must still compile
+	struct BatchOnlyGameObject final : GameObject
+	{
+		void render(SpriteBatch&, float) {}
+	};
 
+	static_assert(Batchable<BatchOnlyGameObject>);
+	static_assert(capabilities_of<BatchOnlyGameObject> & Capability::render);
+}
+
+template class TypedGameObjectBucket<BatchOnlyGameObject>;
+
+
+GameObject* GameObjectRegistry::getGameObjectById(UniqueId uid)
+{
+	for (auto& bucket : _buckets)
+		if (GameObject* obj = bucket->getGameObjectById(uid))
+			return obj;
+	return nullptr;
+}
+
+GameObjectBucket* GameObjectRegistry::findBucket(std::type_index type) const
+{
+	auto it = _bucketsByType.find(type);
+	return it == _bucketsByType.end() ? nullptr : it->second;
+}
+
+bool GameObjectRegistry::destroyGameObject(UniqueId uid)
+{
+	for (auto& bucket : _buckets)
+		if (bucket->destroyGameObject(uid))
+			return true;
+	return false;
+}
+
+bool GameObjectRegistry::sleepGameObject(UniqueId uid)
+{
+	for (auto& bucket : _buckets)
+		if (bucket->sleep(uid))
+			return true;
+	return false;
+}
+
+bool GameObjectRegistry::wakeGameObject(UniqueId uid)
+{
+	for (auto& bucket : _buckets)
+		if (bucket->wake(uid))
+			return true;
+	return false;
+}
+
+void GameObjectRegistry::clear()
+{
+	for (auto& bucket : _buckets)
+		bucket->clear();
+}
+
+void GameObjectRegistry::setObserver(GameObjectObserver* observer)
+{
+	_observer = observer;
+	for (auto& bucket : _buckets)
+		bucket->setObserver(observer);
+}
+
+Size GameObjectRegistry::size() const
+{
+	Size count = 0;
+	for (const auto& bucket : _buckets)
+		count += bucket->size();
+	return count;
+}
+
+void GameObjectRegistry::update(const sf::Time& delta)
+{
+	for (auto& bucket : _buckets)
+		if (bucket->hasCapability(Capability::update))
+			bucket->update(delta);
+}
+
+void GameObjectRegistry::update(const sf::Time& delta, JobSystem& jobs)
+{
+	std::vector<JobHandle> phase;
+	UpdateAccess phaseAccess = UpdateAccess::shared();
+	for (auto& owner : _buckets)
+	{
+		GameObjectBucket* bucket = owner.get();
+		if (!bucket->hasCapability(Capability::update) || bucket->awakeCount() == 0)
+			continue;
+
+		UpdateAccess access = bucket->updateAccess();
+		if (access.conflictsWith(phaseAccess))
+		{
+			jobs.waitAll(phase);
+			phase.clear();
+			phaseAccess = UpdateAccess::shared();
+		}
+
+		if (!access.parallel)
+		{
+			bucket->update(delta);
+			continue;
+		}
+
+		phaseAccess.reads |= access.reads;
+		phaseAccess.writes |= access.writes;
+		if (access.writes)
+			phase.push_back(jobs.schedule([bucket, delta]() { bucket->update(delta); }));
+		else phase.push_back(jobs.schedule([bucket, delta, &jobs]() {
+			jobs.parallelFor(bucket->awakeCount(), update_grain, [bucket, &delta](Size begin, Size end) { bucket->update(delta, begin, end); });
+		}));
+	}
+	jobs.waitAll(phase);
+}
+
+void GameObjectRegistry::render(sf::RenderTarget& canvas, float alpha)
+{
+	for (auto& bucket : _buckets)
+		if (bucket->hasCapability(Capability::render))
+			bucket->render(canvas, alpha);
+}
+
+void GameObjectRegistry::render(sf::RenderTarget& canvas, SpriteBatch& batch, float alpha)
+{
+	for (auto& bucket : _buckets)
+	{
+		if (!bucket->hasCapability(Capability::render))
+			continue;
+
+		if (!bucket->render(batch, alpha))
+		{
+			batch.flush(canvas);
+			bucket->render(canvas, alpha);
+		}
+	}
+	batch.flush(canvas);
+}
+
+void GameObjectRegistry::renderVisible(sf::RenderTarget& canvas, SpriteBatch& batch, const SpatialGrid& index, float alpha, std::pmr::memory_resource* resource)
+{
+	std::pmr::vector<std::pmr::vector<SlotHandle>> visible(_buckets.size(), resource);
+	index.query(SpatialGrid::viewBounds(canvas.getView()), [this, &visible](UniqueId uid) {
+		for (Size i = 0; i < _buckets.size(); ++i)
+		{
+			if (!_buckets[i]->isBounded())
+				continue;
+
+			SlotHandle handle = _buckets[i]->getHandleById(uid);
+			if (handle)
+			{
+				visible[i].push_back(handle);
+				return;
+			}
+		}
+	});
+
+	// Types without bounds() never enter the index, so they are drawn unculled
+	for (Size i = 0; i < _buckets.size(); ++i)
+	{
+		GameObjectBucket* bucket = _buckets[i].get();
+		if (!bucket->hasCapability(Capability::render))
+			continue;
+
+		if (!bucket->isBounded())
+		{
+			if (!bucket->render(batch, alpha))
+			{
+				batch.flush(canvas);
+				bucket->render(canvas, alpha);
+			}
+		}
+		else if (!visible[i].empty() && !bucket->render(batch, visible[i], alpha))
+		{
+			batch.flush(canvas);
+			bucket->render(canvas, visible[i], alpha);
+		}
+	}
+	batch.flush(canvas);
+}
+
+void GameObjectRegistry::dispatchEvent(const sf::Event& event)
+{
+	for (auto& bucket : _buckets)
+		if (bucket->hasCapability(Capability::events))
+			bucket->dispatchEvent(event);
+}
+
+void GameObjectRegistry::syncSpatialIndex(SpatialGrid& index) const
+{
+	for (const auto& bucket : _buckets)
+		bucket->syncSpatialIndex(index);
+}
+
+
+
+bool GameObjectCommandBuffer::empty() const
+{
+	if (!_destroyHandles.empty() || !_destroyIds.empty())
+		return false;
+
+	for (const auto& spawns : _spawns)
+		if (spawns.second->size() > 0)
+			return false;
+	return true;
+}
+
+void GameObjectCommandBuffer::clear()
+{
+	_spawns.clear();
+	_destroyHandles.clear();
+	_destroyIds.clear();
+}
+
+
+
+namespace
+{
+	struct LocalCommandBuffer
+	{
+		UInt64 queueId = 0;
+		GameObjectCommandBuffer* buffer = nullptr;
+	};
+
+	std::atomic<UInt64> command_queue_ids = 0;
+	thread_local LocalCommandBuffer local_command_buffer;
+}
+
+GameObjectCommandQueue::GameObjectCommandQueue() :
+	_id{ ++command_queue_ids }
+{}
+
+GameObjectCommandBuffer& GameObjectCommandQueue::local()
+{
+	if (local_command_buffer.queueId == _id)
+		return *local_command_buffer.buffer;
+
+	std::scoped_lock lock{ _mutex };
+	GameObjectCommandBuffer*& buffer = _buffersByThread[std::this_thread::get_id()];
+	if (!buffer)
+		buffer = _buffers.emplace_back(new GameObjectCommandBuffer()).get();
+
+	local_command_buffer = { _id, buffer };
+	return *buffer;
+}
+
+void GameObjectCommandQueue::flush(GameObjectRegistry& registry)
+{
+	std::scoped_lock lock{ _mutex };
+
+	std::vector<std::pair<std::type_index, GameObjectSpawnList*>> spawns;
+	for (auto& buffer : _buffers)
+	{
+		for (auto& list : buffer->_spawns)
+		{
+			auto it = std::find_if(spawns.begin(), spawns.end(), [&list](const auto& entry) { return entry.first == list.first; });
+			if (it == spawns.end())
+				spawns.emplace_back(list.first, list.second.get());
+			else it->second->absorb(*list.second);
+		}
+	}
+
+	for (auto& list : spawns)
+		list.second->apply(registry);
+
+	std::unordered_map<GameObjectBucket*, std::vector<SlotHandle>> destroys;
+	for (auto& buffer : _buffers)
+	{
+		for (const auto& entry : buffer->_destroyHandles)
+			if (GameObjectBucket* bucket = registry.findBucket(entry.first))
+				destroys[bucket].push_back(entry.second);
+
+		for (UniqueId uid : buffer->_destroyIds)
+		{
+			for (const auto& bucket : registry.buckets())
+			{
+				SlotHandle handle = bucket->getHandleById(uid);
+				if (handle)
+				{
+					destroys[bucket.get()].push_back(handle);
+					break;
+				}
+			}
+		}
+
+		buffer->_destroyHandles.clear();
+		buffer->_destroyIds.clear();
+	}
+
+	for (auto& entry : destroys)
+		entry.first->destroyGameObjects(entry.second);
+}
@@ -1,26 +1,66 @@
 #pragma once
 
 #include "common.h"
+#include "slot_map.h"
+#include "pool.h"
+#include "jobs.h"
+#include "spatial.h"
+#include "batch.h"
 
 class GameController;
+class GameObject;
 
-struct Renderable
-{
-	virtual void render(sf::RenderTarget& canvas) = 0;
-};
+template<std::derived_from<GameObject> _Ty>
+class GameObjectContainer;
 
-struct Updatable
+template<std::derived_from<GameObject> _Ty>
+class GameObjectRef;
+
+struct UpdateAccess
 {
-	virtual void update(const sf::Time& delta) = 0;
+	UInt64 reads = 0;
+	UInt64 writes = 0;
+	bool parallel = false;
+
+	static constexpr UpdateAccess exclusive() { return {}; }
+	static constexpr UpdateAccess shared(UInt64 reads = 0, UInt64 writes = 0) { return { reads, writes, true }; }
+
+	constexpr bool conflictsWith(const UpdateAccess& other) const
+	{
+		return !parallel || !other.parallel || (writes & (other.reads | other.writes)) || (other.writes & reads);
+	}
 };
 
-struct EventDispatcher
+template<typename _Ty>
+concept Bounded = requires(const _Ty& obj) { { obj.bounds() } -> std::convertible_to<sf::FloatRect>; };
+
+/*
+ * Types that draw into a SpriteBatch. Declaring only render(SpriteBatch&, float)
+ * hides GameObject::render(sf::RenderTarget&, float); buckets account for that
+ * and treat such types as having nothing to draw outside of a batch.
+ */
+template<typename _Ty>
+concept Batchable = requires(_Ty& obj, SpriteBatch& batch, float alpha) { obj.render(batch, alpha); };
+
+struct Capability
 {
-	virtual void dispatchEvent(const sf::Event& event) = 0;
+	static constexpr UInt32 none = 0;
+	static constexpr UInt32 update = 1 << 0;
+	static constexpr UInt32 render = 1 << 1;
+	static constexpr UInt32 events = 1 << 2;
+	static constexpr UInt32 all = update | render | events;
 };
 
-class GameObject : public Renderable, public Updatable, public EventDispatcher
+/*
+ * GameObject carries a single vtable. Types that leave a hook untouched lose
+ * the matching capability and their buckets skip that pass entirely; a type
+ * may also declare its own "static constexpr UInt32 capabilities".
+ */
+class GameObject
 {
+public:
+	static constexpr UpdateAccess update_access = UpdateAccess::exclusive();
+
 private:
 	UniqueId _uid = UniqueId::make();
 	GameController* _gc = nullptr;
@@ -37,9 +77,11 @@ public:
 	inline UniqueId uid() const { return _uid; }
 
 public:
-	virtual void render(sf::RenderTarget& canvas) override {}
-	virtual void update(const sf::Time& delta) override {}
-	virtual void dispatchEvent(const sf::Event& event) override {}
+	/* render's alpha is the fraction of a simulation step elapsed since the last tick, for interpolating between states */
+	virtual void render(sf::RenderTarget&, float) {}
+	virtual void update(const sf::Time&) {}
+	/* Returns whether the event was consumed, which stops routed delivery */
+	virtual bool dispatchEvent(const sf::Event&) { return false; }
 
 public:
 	inline GameController& getGameController() const { return *_gc; }
@@ -47,6 +89,65 @@ public:
 
 public:
 	friend class GameController;
+
+	template<std::derived_from<GameObject> _Ty>
+	friend class GameObjectContainer;
+};
+
+
+
+template<typename _Ty>
+concept OverridesUpdate = !requires { requires std::same_as<decltype(&_Ty::update), void (GameObject::*)(const sf::Time&)>; };
+
+template<typename _Ty>
+concept OverridesRender = Batchable<_Ty> || !requires { requires std::same_as<decltype(&_Ty::render), void (GameObject::*)(sf::RenderTarget&, float)>; };
+
+template<typename _Ty>
+concept OverridesDispatchEvent = !requires { requires std::same_as<decltype(&_Ty::dispatchEvent), bool (GameObject::*)(const sf::Event&)>; };
+
+template<std::derived_from<GameObject> _Ty>
+constexpr UInt32 capabilities_of = [] {
+	if constexpr (requires { { _Ty::capabilities } -> std::convertible_to<UInt32>; })
+		return static_cast<UInt32>(_Ty::capabilities);
+	else return (OverridesUpdate<_Ty> ? Capability::update : Capability::none)
+		| (OverridesRender<_Ty> ? Capability::render : Capability::none)
+		| (OverridesDispatchEvent<_Ty> ? Capability::events : Capability::none);
+}();
+
+typedef UInt64 TagMask;
+
+namespace tags
+{
+	static constexpr TagMask none = 0;
+	static constexpr TagMask interactable = TagMask(1) << 0;
+	static constexpr TagMask solid = TagMask(1) << 1;
+	static constexpr TagMask character = TagMask(1) << 2;
+	static constexpr TagMask npc = TagMask(1) << 3;
+	static constexpr TagMask trainer = TagMask(1) << 4;
+	static constexpr TagMask pickup = TagMask(1) << 5;
+	static constexpr TagMask trigger = TagMask(1) << 6;
+	static constexpr TagMask user = TagMask(1) << 32;
+}
+
+template<std::derived_from<GameObject> _Ty>
+constexpr TagMask tags_of = [] {
+	if constexpr (requires { { _Ty::tags } -> std::convertible_to<TagMask>; })
+		return static_cast<TagMask>(_Ty::tags);
+	else return tags::none;
+}();
+
+
+
+/*
+ * Notified when an object leaves its container, so indices keyed by UniqueId
+ * can drop it without polling the registry.
+ */
+class GameObjectObserver
+{
+public:
+	virtual ~GameObjectObserver() = default;
+
+	virtual void onGameObjectDestroyed(UniqueId uid) = 0;
 };
 
 
@@ -54,11 +155,27 @@ public:
 template<std::derived_from<GameObject> _Ty>
 class GameObjectContainer
 {
+public:
+	using value_type = _Ty;
+	using handle_type = SlotHandle;
+	using iterator = typename SlotMap<_Ty>::iterator;
+	using const_iterator = typename SlotMap<_Ty>::const_iterator;
+
 private:
-	std::unordered_map<UniqueId, ref<_Ty>, UniqueId::hash> _objs;
+	SlotMap<_Ty> _objs;
+	FlatHashMap<UniqueId, SlotHandle, UniqueId::hash> _ids;
+	std::pmr::vector<UInt32> _pins;
+	Size _awake = 0;
+	Size _live = 0;
+	std::pmr::vector<_Ty> _recycled;
+	Size _recycleCapacity = 0;
+	Size _reused = 0;
+	GameObjectObserver* _observer = nullptr;
+	std::thread::id _owner = std::this_thread::get_id();
 
 public:
 	GameObjectContainer() = default;
+	explicit GameObjectContainer(std::pmr::memory_resource* resource) : _objs{ resource }, _ids{ resource }, _pins{ resource }, _recycled{ resource } {}
 	GameObjectContainer(GameObjectContainer&&) noexcept = default;
 	~GameObjectContainer() = default;
 
@@ -68,111 +185,831 @@ public:
 	GameObjectContainer& operator= (const GameObjectContainer&) = delete;
 
 public:
-	wref<_Ty> getGameObjectById(UniqueId uid)
+	inline _Ty* getGameObject(SlotHandle handle) { return _liveOrNull(_objs.get(handle)); }
+	inline const _Ty* getGameObject(SlotHandle handle) const { return _liveOrNull(_objs.get(handle)); }
+
+	inline _Ty* getGameObject(CompactId id) { return _liveOrNull(_objs.get(id)); }
+	inline const _Ty* getGameObject(CompactId id) const { return _liveOrNull(_objs.get(id)); }
+
+	inline _Ty* getGameObjectById(UniqueId uid) { return _objs.get(getHandleById(uid)); }
+	inline const _Ty* getGameObjectById(UniqueId uid) const { return _objs.get(getHandleById(uid)); }
+
+	SlotHandle getHandleById(UniqueId uid) const
 	{
-		auto it = _objs.find(uid);
-		return it == _objs.end() ? nullptr : it->second;
+		auto it = _ids.find(uid);
+		return it == _ids.end() ? SlotHandle{} : it->second;
 	}
 
-	void forEachGameObject(const std::function<void(wref<_Ty>)>& consumer)
+	inline bool hasGameObject(SlotHandle handle) const { return _objs.contains(handle) && _objs.denseIndexOf(handle) < _live; }
+	inline bool hasGameObject(UniqueId uid) const { return _ids.contains(uid); }
+
+	template<std::invocable<_Ty&> _Fty>
+	void forEachGameObject(_Fty&& consumer)
 	{
-		for (auto& obj : _objs)
-			consumer(obj->second);
+		for (_Ty& obj : live())
+			consumer(obj);
 	}
 
-	void forEachGameObject(const std::function<void(const wref<_Ty>)>& consumer) const
+	template<std::invocable<const _Ty&> _Fty>
+	void forEachGameObject(_Fty&& consumer) const
 	{
-		for (const auto& obj : _objs)
-			consumer(obj->second);
+		for (const _Ty& obj : live())
+			consumer(obj);
 	}
 
-	bool destroyGameObject(UniqueId uid)
+	template<std::predicate<const _Ty&> _PredTy>
+	inline auto filter(_PredTy pred) { return live() | std::views::filter(std::move(pred)); }
+
+	template<std::predicate<const _Ty&> _PredTy>
+	inline auto filter(_PredTy pred) const { return live() | std::views::filter(std::move(pred)); }
+
+	bool destroyGameObject(SlotHandle handle)
+	{
+		const _Ty* obj = getGameObject(handle);
+		if (!obj)
+			return false;
+
+		_ids.erase(obj->uid());
+		if (_observer)
+			_observer->onGameObjectDestroyed(obj->uid());
+		_retire(handle);
+		if (pinCount(handle) == 0)
+			_erase(handle);
+		return true;
+	}
+
+	inline bool destroyGameObject(UniqueId uid) { return destroyGameObject(getHandleById(uid)); }
+
+	inline SlotHandle addGameObject(const _Ty& obj) { return emplaceGameObject(obj); }
+	inline SlotHandle addGameObject(_Ty&& obj) { return emplaceGameObject(std::move(obj)); }
+
+	template<typename... _Args>
+	SlotHandle emplaceGameObject(_Args&&... args)
 	{
-		auto it = _objs.find(uid);
-		if (it != _objs.end())
+		if constexpr (Recyclable<_Ty, _Args...>)
 		{
-			it->reset();
-			_objs.erase(it);
-			return true;
+			if (!_recycled.empty())
+			{
+				_Ty obj = std::move(_recycled.back());
+				_recycled.pop_back();
+				obj.recycle(std::forward<_Args>(args)...);
+				obj._uid = UniqueId::make();
+				obj._gc = nullptr;
+				++_reused;
+				return _insert(std::move(obj));
+			}
 		}
-		return false;
+		return _insert(std::forward<_Args>(args)...);
+	}
+
+	inline void setRecycleCapacity(Size capacity)
+	{
+		_recycleCapacity = capacity;
+		if (_recycled.size() > capacity)
+			_recycled.erase(_recycled.begin() + capacity, _recycled.end());
+	}
+
+	inline Size recycleCapacity() const { return _recycleCapacity; }
+	inline Size recycledCount() const { return _recycled.size(); }
+	inline Size reusedCount() const { return _reused; }
+	inline void clearRecycled() { _recycled.clear(); }
+
+	GameObjectRef<_Ty> share(SlotHandle handle);
+	inline GameObjectRef<_Ty> share(UniqueId uid) { return share(getHandleById(uid)); }
+
+	inline UInt32 pinCount(SlotHandle handle) const { return _objs.contains(handle) && handle.index() < _pins.size() ? _pins[handle.index()] : 0; }
+
+	inline bool isAwake(SlotHandle handle) const { return _objs.contains(handle) && _objs.denseIndexOf(handle) < _awake; }
+
+	bool sleep(SlotHandle handle)
+	{
+		if (!isAwake(handle))
+			return false;
+
+		_objs.swapDense(_objs.denseIndexOf(handle), --_awake);
+		return true;
 	}
 
-	wref<_Ty> addGameObject(wref<_Ty> obj)
+	bool wake(SlotHandle handle)
 	{
-		UniqueId uid = obj.uid();
-		auto it = _objs.find(uid);
-		if (it != _objs.end())
-			return nullptr;
+		if (!hasGameObject(handle) || isAwake(handle))
+			return false;
+
+		_objs.swapDense(_objs.denseIndexOf(handle), _awake++);
+		return true;
+	}
+
+	inline bool sleep(UniqueId uid) { return sleep(getHandleById(uid)); }
+	inline bool wake(UniqueId uid) { return wake(getHandleById(uid)); }
+
+	inline Size awakeCount() const { return _awake; }
+	inline std::span<_Ty> awake() { return { _objs.data(), _awake }; }
+	inline std::span<const _Ty> awake() const { return { _objs.data(), _awake }; }
 
-		//_objs[uid] = std::make_shared()
+	inline void reserve(Size count) { _objs.reserve(count), _ids.reserve(count); }
+	inline std::span<_Ty> live() { return { _objs.data(), _live }; }
+	inline std::span<const _Ty> live() const { return { _objs.data(), _live }; }
+
+	void clear()
+	{
+		if (_observer)
+			for (const _Ty& obj : live())
+				_observer->onGameObjectDestroyed(obj.uid());
+		_objs.clear(), _ids.clear(), _pins.clear(), _awake = 0, _live = 0;
 	}
 
+	inline void setObserver(GameObjectObserver* observer) { _observer = observer; }
+	inline GameObjectObserver* observer() const { return _observer; }
+
+	inline Size size() const { return _live; }
+	inline bool empty() const { return _live == 0; }
+	inline Size capacity() const { return _objs.capacity(); }
+	inline std::pmr::memory_resource* resource() const { return _objs.resource(); }
+	inline Size retainedCount() const { return _objs.size() - _live; }
+
+	inline SlotHandle handleAt(Offset index) const { return _objs.handleAt(index); }
+	inline Offset denseIndexOf(SlotHandle handle) const { return _objs.denseIndexOf(handle); }
+
 public:
-	class iterator;
-	class const_iterator;
+	inline iterator begin() { return _objs.begin(); }
+	inline const_iterator begin() const { return _objs.begin(); }
+	inline const_iterator cbegin() const { return _objs.cbegin(); }
+
+	inline iterator end() { return _objs.begin() + _live; }
+	inline const_iterator end() const { return _objs.begin() + _live; }
+	inline const_iterator cend() const { return _objs.cbegin() + _live; }
+
+private:
+	template<typename _PtrTy>
+	inline _PtrTy* _liveOrNull(_PtrTy* obj) const { return obj && static_cast<Size>(obj - _objs.data()) < _live ? obj : nullptr; }
 
-	class iterator
+	template<typename... _Args>
+	SlotHandle _insert(_Args&&... args)
 	{
-	private:
-		decltype(_objs)::iterator _it;
+		SlotHandle handle = _objs.emplace(std::forward<_Args>(args)...);
+		UniqueId uid = _objs[handle].uid();
+		if (!_ids.try_emplace(uid, handle).second)
+		{
+			_objs.erase(handle);
+			return {};
+		}
 
-	public:
-		using iterator_category = std::forward_iterator_tag;
-		using difference_type = std::ptrdiff_t;
-		using value_type = wref<_Ty>;
-		using pointer = ref<_Ty>*;
-		using reference = wref<_Ty>;
+		_objs.swapDense(_objs.size() - 1, _live++);
+		_objs.swapDense(_live - 1, _awake++);
+		return handle;
+	}
+
+	void _retire(SlotHandle handle)
+	{
+		Offset index = _objs.denseIndexOf(handle);
+		if (index < _awake)
+			_objs.swapDense(index, --_awake), index = _awake;
+		_objs.swapDense(index, --_live);
+	}
 
-		iterator(const decltype(_objs)::iterator& it) : _it{ it } {}
+	void _erase(SlotHandle handle)
+	{
+		_objs.swapDense(_objs.denseIndexOf(handle), _objs.size() - 1);
+		if (_recycled.size() < _recycleCapacity)
+			_recycled.push_back(std::move(_objs[handle]));
+		if (handle.index() < _pins.size())
+			_pins[handle.index()] = 0;
+		_objs.erase(handle);
+	}
 
-		inline reference operator* () { return *_it; }
-		inline pointer operator-> () { return std::addressof(*_it); }
+	void _pin(SlotHandle handle)
+	{
+		assert(std::this_thread::get_id() == _owner && "GameObjectRef pins are main-thread only");
+		if (!_objs.contains(handle))
+			return;
 
-		iterator& operator++ () { return ++_it, *this; }
-		iterator& operator++ (int) { return _it++, *this; }
+		if (_pins.size() <= handle.index())
+			_pins.resize(handle.index() + 1, 0);
+		++_pins[handle.index()];
+	}
 
-		inline bool operator== (const iterator& right) const { return _it == right._it; }
-		inline bool operator!= (const iterator& right) const { return _it != right._it; }
-	};
+	void _unpin(SlotHandle handle)
+	{
+		assert(std::this_thread::get_id() == _owner && "GameObjectRef pins are main-thread only");
+		if (!_objs.contains(handle) || --_pins[handle.index()] > 0)
+			return;
+
+		if (_objs.denseIndexOf(handle) >= _live)
+			_erase(handle);
+	}
 
-	class const_iterator
+public:
+	friend class GameObjectRef<_Ty>;
+};
+
+
+
+/*
+ * Non-atomic strong reference to an object stored in a GameObjectContainer.
+ * The count lives in the container next to the slot, so copies touch no
+ * atomics and no control block. Destroying a referenced object removes it
+ * from lookups, updates and iteration right away, but the storage is kept
+ * until the last reference is dropped. A plain SlotHandle acts as the weak
+ * counterpart: share() turns it back into a strong reference.
+ * Refs are created, copied and dropped on the thread that owns the container;
+ * parallel updates hold SlotHandles and resolve them instead.
+ */
+template<std::derived_from<GameObject> _Ty>
+class GameObjectRef
+{
+private:
+	GameObjectContainer<_Ty>* _container = nullptr;
+	SlotHandle _handle;
+
+public:
+	GameObjectRef() = default;
+	GameObjectRef(const GameObjectRef& other) : _container{ other._container }, _handle{ other._handle } { _retain(); }
+	GameObjectRef(GameObjectRef&& other) noexcept : _container{ std::exchange(other._container, nullptr) }, _handle{ std::exchange(other._handle, {}) } {}
+	~GameObjectRef() { _release(); }
+
+	GameObjectRef& operator= (const GameObjectRef& right)
 	{
-	private:
-		decltype(_objs)::const_iterator _it;
+		GameObjectRef{ right }.swap(*this);
+		return *this;
+	}
+
+	GameObjectRef& operator= (GameObjectRef&& right) noexcept
+	{
+		GameObjectRef{ std::move(right) }.swap(*this);
+		return *this;
+	}
+
+public:
+	inline _Ty* get() const { return _container ? _container->_objs.get(_handle) : nullptr; }
+	inline _Ty& operator* () const { return *get(); }
+	inline _Ty* operator-> () const { return get(); }
+
+	inline operator bool() const { return get(); }
+	inline bool operator! () const { return !get(); }
+
+	inline bool operator== (const GameObjectRef& right) const { return _container == right._container && _handle == right._handle; }
+
+	inline SlotHandle handle() const { return _handle; }
+	inline bool isDestroyed() const { return !_container || !_container->hasGameObject(_handle); }
+	inline UInt32 useCount() const { return _container ? _container->pinCount(_handle) : 0; }
+
+	inline void reset() { GameObjectRef{}.swap(*this); }
 
+	inline void swap(GameObjectRef& other) noexcept
+	{
+		std::swap(_container, other._container);
+		std::swap(_handle, other._handle);
+	}
+
+private:
+	inline GameObjectRef(GameObjectContainer<_Ty>* container, SlotHandle handle) : _container{ container }, _handle{ handle } { _retain(); }
+
+	inline void _retain() { if (_container) _container->_pin(_handle); }
+	inline void _release() { if (_container) _container->_unpin(_handle); }
+
+public:
+	friend class GameObjectContainer<_Ty>;
+};
+
+template<std::derived_from<GameObject> _Ty>
+GameObjectRef<_Ty> GameObjectContainer<_Ty>::share(SlotHandle handle)
+{
+	return hasGameObject(handle) ? GameObjectRef<_Ty>{ this, handle } : GameObjectRef<_Ty>{};
+}
+
+
+
+class GameObjectBucket
+{
+public:
+	virtual ~GameObjectBucket() = default;
+
+	virtual std::type_index type() const = 0;
+	virtual Size size() const = 0;
+	virtual Size awakeCount() const = 0;
+
+	virtual TagMask tags() const = 0;
+	inline bool hasTags(TagMask mask) const { return (tags() & mask) == mask; }
+
+	virtual std::byte* data() = 0;
+	virtual Size stride() const = 0;
+	virtual GameObject* objectAt(Offset index) = 0;
+
+	virtual GameObject* getGameObjectById(UniqueId uid) = 0;
+	virtual SlotHandle getHandleById(UniqueId uid) const = 0;
+	virtual bool destroyGameObject(UniqueId uid) = 0;
+	virtual void destroyGameObjects(std::vector<SlotHandle>& handles) = 0;
+	virtual void clear() = 0;
+	virtual void setObserver(GameObjectObserver* observer) = 0;
+
+	virtual bool sleep(UniqueId uid) = 0;
+	virtual bool wake(UniqueId uid) = 0;
+
+	virtual UpdateAccess updateAccess() const = 0;
+	virtual UInt32 capabilities() const = 0;
+	inline bool hasCapability(UInt32 capability) const { return capabilities() & capability; }
+
+	virtual void update(const sf::Time& delta) = 0;
+	virtual void update(const sf::Time& delta, Size begin, Size end) = 0;
+	virtual void render(sf::RenderTarget& canvas, float alpha) = 0;
+	virtual void render(sf::RenderTarget& canvas, std::span<const SlotHandle> handles, float alpha) = 0;
+	virtual bool render(SpriteBatch& batch, float alpha) = 0;
+	virtual bool render(SpriteBatch& batch, std::span<const SlotHandle> handles, float alpha) = 0;
+	virtual void dispatchEvent(const sf::Event& event) = 0;
+
+	virtual bool isBounded() const = 0;
+	virtual void syncSpatialIndex(SpatialGrid& index) const = 0;
+};
+
+template<std::derived_from<GameObject> _Ty>
+class TypedGameObjectBucket final : public GameObjectBucket
+{
+private:
+	GameObjectContainer<_Ty> _objs;
+
+public:
+	TypedGameObjectBucket() = default;
+	explicit TypedGameObjectBucket(std::pmr::memory_resource* resource) : _objs{ resource } {}
+
+public:
+	inline GameObjectContainer<_Ty>& container() { return _objs; }
+	inline const GameObjectContainer<_Ty>& container() const { return _objs; }
+
+	std::type_index type() const override { return typeid(_Ty); }
+	Size size() const override { return _objs.size(); }
+	Size awakeCount() const override { return _objs.awakeCount(); }
+
+	TagMask tags() const override { return tags_of<_Ty>; }
+	std::byte* data() override { return reinterpret_cast<std::byte*>(_objs.live().data()); }
+	Size stride() const override { return sizeof(_Ty); }
+	GameObject* objectAt(Offset index) override { return &_objs.live()[index]; }
+
+	GameObject* getGameObjectById(UniqueId uid) override { return _objs.getGameObjectById(uid); }
+	SlotHandle getHandleById(UniqueId uid) const override { return _objs.getHandleById(uid); }
+	bool destroyGameObject(UniqueId uid) override { return _objs.destroyGameObject(uid); }
+	void clear() override { _objs.clear(); }
+	void setObserver(GameObjectObserver* observer) override { _objs.setObserver(observer); }
+
+	bool sleep(UniqueId uid) override { return _objs.sleep(uid); }
+	bool wake(UniqueId uid) override { return _objs.wake(uid); }
+
+	void destroyGameObjects(std::vector<SlotHandle>& handles) override
+	{
+		std::erase_if(handles, [this](SlotHandle handle) { return !_objs.hasGameObject(handle); });
+		std::sort(handles.begin(), handles.end());
+		handles.erase(std::unique(handles.begin(), handles.end()), handles.end());
+		std::sort(handles.begin(), handles.end(), [this](SlotHandle left, SlotHandle right) {
+			return _objs.denseIndexOf(left) > _objs.denseIndexOf(right);
+		});
+
+		for (SlotHandle handle : handles)
+			_objs.destroyGameObject(handle);
+	}
+
+	UpdateAccess updateAccess() const override { return _Ty::update_access; }
+	UInt32 capabilities() const override { return capabilities_of<_Ty>; }
+
+	void update(const sf::Time& delta) override
+	{
+		if constexpr (capabilities_of<_Ty> & Capability::update)
+			for (_Ty& obj : _objs.awake())
+				obj._Ty::update(delta);
+	}
+
+	void update(const sf::Time& delta, Size begin, Size end) override
+	{
+		if constexpr (capabilities_of<_Ty> & Capability::update)
+		{
+			std::span<_Ty> objs = _objs.awake();
+			for (Size i = begin; i < end; ++i)
+				objs[i]._Ty::update(delta);
+		}
+	}
+
+	void render(sf::RenderTarget& canvas, float alpha) override
+	{
+		if constexpr (capabilities_of<_Ty> & Capability::render)
+			for (_Ty& obj : _objs)
+				_render(obj, canvas, alpha);
+	}
+
+	void render(sf::RenderTarget& canvas, std::span<const SlotHandle> handles, float alpha) override
+	{
+		if constexpr (capabilities_of<_Ty> & Capability::render)
+			for (SlotHandle handle : handles)
+				if (_Ty* obj = _objs.getGameObject(handle))
+					_render(*obj, canvas, alpha);
+	}
+
+	bool render(SpriteBatch& batch, float alpha) override
+	{
+		if constexpr (Batchable<_Ty>)
+		{
+			if constexpr (capabilities_of<_Ty> & Capability::render)
+				for (_Ty& obj : _objs)
+					obj._Ty::render(batch, alpha);
+			return true;
+		}
+		else return false;
+	}
+
+	bool render(SpriteBatch& batch, std::span<const SlotHandle> handles, float alpha) override
+	{
+		if constexpr (Batchable<_Ty>)
+		{
+			if constexpr (capabilities_of<_Ty> & Capability::render)
+				for (SlotHandle handle : handles)
+					if (_Ty* obj = _objs.getGameObject(handle))
+						obj->_Ty::render(batch, alpha);
+			return true;
+		}
+		else return false;
+	}
+
+	void dispatchEvent(const sf::Event& event) override
+	{
+		if constexpr (capabilities_of<_Ty> & Capability::events)
+			for (_Ty& obj : _objs)
+				obj._Ty::dispatchEvent(event);
+	}
+
+	bool isBounded() const override { return Bounded<_Ty>; }
+
+	/* Sleepers do not update, so they keep the bounds synced while they were awake */
+	void syncSpatialIndex(SpatialGrid& index) const override
+	{
+		if constexpr (Bounded<_Ty>)
+		{
+			for (const _Ty& obj : _objs.awake())
+				index.update(obj.uid(), obj.bounds());
+		}
+	}
+
+private:
+	static inline void _render(_Ty& obj, sf::RenderTarget& canvas, float alpha)
+	{
+		if constexpr (requires { obj._Ty::render(canvas, alpha); })
+			obj._Ty::render(canvas, alpha);
+	}
+};
+
+
+
+struct GameObjectView
+{
+	GameObjectBucket* bucket;
+	std::ptrdiff_t offset;
+};
+
+/*
+ * Range over the live objects of every bucket whose type derives from _Ty and
+ * carries the requested tags. The matching buckets are resolved once per
+ * queried type, so iteration only walks the selected arrays by stride.
+ */
+template<std::derived_from<GameObject> _Ty>
+class GameObjectQuery : public std::ranges::view_interface<GameObjectQuery<_Ty>>
+{
+public:
+	class Iterator
+	{
 	public:
+		using iterator_concept = std::forward_iterator_tag;
 		using iterator_category = std::forward_iterator_tag;
+		using value_type = _Ty;
 		using difference_type = std::ptrdiff_t;
-		using value_type = const wref<_Ty>;
-		using pointer = const ref<_Ty>*;
-		using reference = const wref<_Ty>;
+		using pointer = _Ty*;
+		using reference = _Ty&;
 
-		const_iterator(const decltype(_objs)::const_iterator& it) : _it{ it } {}
-		const_iterator(const iterator& it) : _it{ it._it } {}
+	private:
+		const std::vector<GameObjectView>* _views = nullptr;
+		Size _view = 0;
+		Size _count = 0;
+		TagMask _tags = tags::none;
+		std::byte* _cursor = nullptr;
+		std::byte* _end = nullptr;
+		Size _stride = 0;
+
+	public:
+		Iterator() = default;
+		Iterator(const std::vector<GameObjectView>* views, Size count, TagMask tags) : _views{ views }, _count{ count }, _tags{ tags } { _seek(); }
 
-		inline reference operator* () { return *_it; }
-		inline pointer operator-> () { return std::addressof(*_it); }
+		inline _Ty& operator* () const { return *reinterpret_cast<_Ty*>(_cursor); }
+		inline _Ty* operator-> () const { return reinterpret_cast<_Ty*>(_cursor); }
 
-		const_iterator& operator++ () { return ++_it, *this; }
-		const_iterator& operator++ (int) { return _it++, *this; }
+		Iterator& operator++ ()
+		{
+			if ((_cursor += _stride) == _end)
+			{
+				++_view;
+				_seek();
+			}
+			return *this;
+		}
 
-		inline bool operator== (const const_iterator& right) const { return _it == right._it; }
-		inline bool operator!= (const const_iterator& right) const { return _it != right._it; }
+		inline Iterator operator++ (int) { Iterator it = *this; ++*this; return it; }
 
-		inline bool operator== (const iterator& right) const { return _it == right._it; }
-		inline bool operator!= (const iterator& right) const { return _it != right._it; }
+		inline bool operator== (const Iterator& right) const { return _cursor == right._cursor; }
 
-		friend bool operator== (const iterator& left, const const_iterator& right) const { return const_iterator(left) == right; }
-		friend bool operator!= (const iterator& left, const const_iterator& right) const { return const_iterator(left) != right; }
+	private:
+		void _seek()
+		{
+			for (; _view < _count; ++_view)
+			{
+				const GameObjectView& view = (*_views)[_view];
+				Size size = view.bucket->size();
+				if (size && view.bucket->hasTags(_tags))
+				{
+					_stride = view.bucket->stride();
+					_cursor = view.bucket->data() + view.offset;
+					_end = _cursor + size * _stride;
+					return;
+				}
+			}
+			_cursor = nullptr;
+		}
 	};
 
-	inline iterator begin() { return iterator(_objs.begin()); }
-	inline iterator begin() const { return iterator(_objs.begin()); }
-	inline iterator cbegin() const { return iterator(_objs.cbegin()); }
+private:
+	const std::vector<GameObjectView>* _views = nullptr;
+	Size _count = 0;
+	TagMask _tags = tags::none;
+
+public:
+	GameObjectQuery() = default;
+	GameObjectQuery(const std::vector<GameObjectView>& views, TagMask tags) : _views{ &views }, _count{ views.size() }, _tags{ tags } {}
+
+public:
+	inline Iterator begin() const { return { _views, _count, _tags }; }
+	inline Iterator end() const { return {}; }
 
-	inline iterator end() { return iterator(_objs.end()); }
-	inline iterator end() const { return iterator(_objs.end()); }
-	inline iterator cend() const { return iterator(_objs.cend()); }
+	inline TagMask tags() const { return _tags; }
+
+	Size count() const
+	{
+		Size count = 0;
+		for (Size i = 0; i < _count; ++i)
+			if ((*_views)[i].bucket->hasTags(_tags))
+				count += (*_views)[i].bucket->size();
+		return count;
+	}
+
+	template<std::invocable<_Ty&> _Fty>
+	void forEach(_Fty&& action) const
+	{
+		for (Size i = 0; i < _count; ++i)
+		{
+			const GameObjectView& view = (*_views)[i];
+			if (!view.bucket->hasTags(_tags))
+				continue;
+
+			Size stride = view.bucket->stride();
+			std::byte* cursor = view.bucket->data() + view.offset;
+			std::byte* end = cursor + view.bucket->size() * stride;
+			for (; cursor != end; cursor += stride)
+				action(*reinterpret_cast<_Ty*>(cursor));
+		}
+	}
 };
 
+
+
+class GameObjectRegistry
+{
+public:
+	static constexpr Size update_grain = 256;
+
+private:
+	struct SubtypeViews
+	{
+		std::vector<GameObjectView> views;
+		std::vector<GameObjectBucket*> pending;
+		Size scanned = 0;
+	};
+
+private:
+	std::vector<uref<GameObjectBucket>> _buckets;
+	std::unordered_map<std::type_index, GameObjectBucket*> _bucketsByType;
+	FlatHashMap<std::type_index, uref<SubtypeViews>> _subtypes;
+	std::pmr::memory_resource* _resource = std::pmr::get_default_resource();
+	GameObjectObserver* _observer = nullptr;
+
+public:
+	GameObjectRegistry() = default;
+	explicit GameObjectRegistry(std::pmr::memory_resource* resource) : _resource{ resource } {}
+	GameObjectRegistry(GameObjectRegistry&&) noexcept = default;
+	~GameObjectRegistry() = default;
+
+	GameObjectRegistry& operator= (GameObjectRegistry&&) noexcept = default;
+
+	GameObjectRegistry(const GameObjectRegistry&) = delete;
+	GameObjectRegistry& operator= (const GameObjectRegistry&) = delete;
+
+public:
+	template<std::derived_from<GameObject> _Ty>
+	GameObjectContainer<_Ty>& registerType()
+	{
+		auto it = _bucketsByType.find(typeid(_Ty));
+		if (it != _bucketsByType.end())
+			return static_cast<TypedGameObjectBucket<_Ty>*>(it->second)->container();
+
+		auto bucket = new TypedGameObjectBucket<_Ty>(_resource);
+		bucket->setObserver(_observer);
+		_buckets.emplace_back(bucket);
+		_bucketsByType.emplace(typeid(_Ty), bucket);
+		return bucket->container();
+	}
+
+	template<std::derived_from<GameObject> _Ty>
+	inline GameObjectContainer<_Ty>& container() { return registerType<_Ty>(); }
+
+	template<std::derived_from<GameObject> _Ty>
+	const GameObjectContainer<_Ty>* findContainer() const
+	{
+		auto it = _bucketsByType.find(typeid(_Ty));
+		return it == _bucketsByType.end() ? nullptr : &static_cast<const TypedGameObjectBucket<_Ty>*>(it->second)->container();
+	}
+
+	GameObjectBucket* findBucket(std::type_index type) const;
+
+	template<std::derived_from<GameObject> _Ty = GameObject>
+	inline GameObjectQuery<_Ty> query(TagMask tags = tags::none) { return { _resolve<_Ty>(), tags }; }
+
+	template<std::derived_from<GameObject> _Ty = GameObject, std::invocable<_Ty&> _Fty>
+	inline void visit(_Fty&& action, TagMask tags = tags::none) { query<_Ty>(tags).forEach(std::forward<_Fty>(action)); }
+	inline const std::vector<uref<GameObjectBucket>>& buckets() const { return _buckets; }
+	inline std::pmr::memory_resource* resource() const { return _resource; }
+
+	template<std::derived_from<GameObject> _Ty, typename... _Args>
+	inline SlotHandle emplaceGameObject(_Args&&... args) { return registerType<_Ty>().emplaceGameObject(std::forward<_Args>(args)...); }
+
+	template<std::derived_from<GameObject> _Ty>
+	inline SlotHandle addGameObject(_Ty&& obj) { return registerType<std::remove_cvref_t<_Ty>>().addGameObject(std::forward<_Ty>(obj)); }
+
+	GameObject* getGameObjectById(UniqueId uid);
+	bool destroyGameObject(UniqueId uid);
+	void clear();
+
+	void setObserver(GameObjectObserver* observer);
+	inline GameObjectObserver* observer() const { return _observer; }
+
+	bool sleepGameObject(UniqueId uid);
+	bool wakeGameObject(UniqueId uid);
+
+	Size size() const;
+	inline Size typeCount() const { return _buckets.size(); }
+
+	void update(const sf::Time& delta);
+	void update(const sf::Time& delta, JobSystem& jobs);
+	void render(sf::RenderTarget& canvas, float alpha);
+	void render(sf::RenderTarget& canvas, SpriteBatch& batch, float alpha);
+	void renderVisible(sf::RenderTarget& canvas, SpriteBatch& batch, const SpatialGrid& index, float alpha, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+	void dispatchEvent(const sf::Event& event);
+
+	void syncSpatialIndex(SpatialGrid& index) const;
+
+private:
+	template<std::derived_from<GameObject> _Ty>
+	const std::vector<GameObjectView>& _resolve()
+	{
+		uref<SubtypeViews>& subtype = _subtypes[typeid(_Ty)];
+		if (!subtype)
+			subtype = std::make_unique<SubtypeViews>();
+
+		for (; subtype->scanned < _buckets.size(); ++subtype->scanned)
+			subtype->pending.push_back(_buckets[subtype->scanned].get());
+
+		// A bucket's base offset can only be taken from a live object, so empty buckets stay pending
+		std::erase_if(subtype->pending, [&views = subtype->views](GameObjectBucket* bucket) {
+			if (bucket->type() == typeid(_Ty))
+				views.push_back({ bucket, 0 });
+			else if (bucket->size() == 0)
+				return false;
+			else if (_Ty* obj = dynamic_cast<_Ty*>(bucket->objectAt(0)))
+				views.push_back({ bucket, reinterpret_cast<std::byte*>(obj) - bucket->data() });
+			return true;
+		});
+		return subtype->views;
+	}
+};
+
+
+
+class GameObjectSpawnList
+{
+public:
+	virtual ~GameObjectSpawnList() = default;
+
+	virtual Size size() const = 0;
+	virtual void absorb(GameObjectSpawnList& other) = 0;
+	virtual void apply(GameObjectRegistry& registry) = 0;
+};
+
+template<std::derived_from<GameObject> _Ty>
+class TypedGameObjectSpawnList final : public GameObjectSpawnList
+{
+private:
+	std::vector<_Ty> _objs;
+
+public:
+	template<typename... _Args>
+	inline _Ty& emplace(_Args&&... args) { return _objs.emplace_back(std::forward<_Args>(args)...); }
+
+	Size size() const override { return _objs.size(); }
+
+	void absorb(GameObjectSpawnList& other) override
+	{
+		auto& objs = static_cast<TypedGameObjectSpawnList&>(other)._objs;
+		_objs.insert(_objs.end(), std::make_move_iterator(objs.begin()), std::make_move_iterator(objs.end()));
+		objs.clear();
+	}
+
+	void apply(GameObjectRegistry& registry) override
+	{
+		std::sort(_objs.begin(), _objs.end(), [](const _Ty& left, const _Ty& right) { return left.uid() < right.uid(); });
+
+		GameObjectContainer<_Ty>& container = registry.container<_Ty>();
+		Size needed = container.size() + _objs.size();
+		if (needed > container.capacity())
+			container.reserve(std::max(needed, container.capacity() * 2));
+
+		for (_Ty& obj : _objs)
+			container.addGameObject(std::move(obj));
+		_objs.clear();
+	}
+};
+
+
+
+class GameObjectCommandBuffer
+{
+private:
+	std::vector<std::pair<std::type_index, uref<GameObjectSpawnList>>> _spawns;
+	std::vector<std::pair<std::type_index, SlotHandle>> _destroyHandles;
+	std::vector<UniqueId> _destroyIds;
+
+public:
+	GameObjectCommandBuffer() = default;
+	GameObjectCommandBuffer(GameObjectCommandBuffer&&) noexcept = default;
+	~GameObjectCommandBuffer() = default;
+
+	GameObjectCommandBuffer& operator= (GameObjectCommandBuffer&&) noexcept = default;
+
+	GameObjectCommandBuffer(const GameObjectCommandBuffer&) = delete;
+	GameObjectCommandBuffer& operator= (const GameObjectCommandBuffer&) = delete;
+
+public:
+	template<std::derived_from<GameObject> _Ty, typename... _Args>
+	inline _Ty& stage(_Args&&... args) { return _spawnList<_Ty>().emplace(std::forward<_Args>(args)...); }
+
+	template<std::derived_from<GameObject> _Ty, typename... _Args>
+	inline UniqueId spawn(_Args&&... args) { return stage<_Ty>(std::forward<_Args>(args)...).uid(); }
+
+	template<typename _Ty> requires std::derived_from<std::remove_cvref_t<_Ty>, GameObject>
+	inline UniqueId spawn(_Ty&& obj) { return stage<std::remove_cvref_t<_Ty>>(std::forward<_Ty>(obj)).uid(); }
+
+	inline void destroy(UniqueId uid) { _destroyIds.push_back(uid); }
+
+	template<std::derived_from<GameObject> _Ty>
+	inline void destroy(SlotHandle handle) { _destroyHandles.emplace_back(typeid(_Ty), handle); }
+
+	bool empty() const;
+	void clear();
+
+private:
+	template<std::derived_from<GameObject> _Ty>
+	TypedGameObjectSpawnList<_Ty>& _spawnList()
+	{
+		for (auto& spawns : _spawns)
+			if (spawns.first == typeid(_Ty))
+				return static_cast<TypedGameObjectSpawnList<_Ty>&>(*spawns.second);
+
+		auto list = new TypedGameObjectSpawnList<_Ty>();
+		_spawns.emplace_back(typeid(_Ty), list);
+		return *list;
+	}
+
+public:
+	friend class GameObjectCommandQueue;
+};
+
+
+
+class GameObjectCommandQueue
+{
+private:
+	UInt64 _id;
+	std::mutex _mutex;
+	std::vector<uref<GameObjectCommandBuffer>> _buffers;
+	std::unordered_map<std::thread::id, GameObjectCommandBuffer*> _buffersByThread;
+
+public:
+	GameObjectCommandQueue();
+	~GameObjectCommandQueue() = default;
+
+	GameObjectCommandQueue(const GameObjectCommandQueue&) = delete;
+	GameObjectCommandQueue& operator= (const GameObjectCommandQueue&) = delete;
+
+	GameObjectCommandBuffer& local();
+
+	void flush(GameObjectRegistry& registry);
+};
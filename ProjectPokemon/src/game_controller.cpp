@@ -0,0 +1,118 @@
+#include "game_controller.h"
+
+GameController::GameController() :
+	_jobs{ JobSystem::defaultWorkerCount() },
+	_scenePool{ std::pmr::pool_options{ 0, scene_pool_largest_block }, &_sceneArena },
+	_loader{ _jobs, _resources },
+	_reloader{ _resources, _loader },
+	_objects{ &_scenePool }
+{
+	_objects.setObserver(this);
+}
+
+void GameController::open(const sf::VideoMode& mode, const String& title, UInt32 style)
+{
+	_window.create(mode, title, style);
+}
+
+int GameController::run()
+{
+	if (!_window.isOpen())
+		return 1;
+
+	sf::Clock clock;
+	_running = true;
+	while (_running && _window.isOpen())
+	{
+		_frameArena.nextFrame();
+		_pollEvents();
+		advance(clock.restart());
+		if (_reloader.isEnabled())
+			_reloader.update();
+		_loader.pump(sf::microseconds(_loadBudget));
+
+		_window.clear();
+		render(_window, _alpha);
+		_window.display();
+	}
+
+	_running = false;
+	return 0;
+}
+
+UInt32 GameController::advance(const sf::Time& elapsed)
+{
+	_accumulator += std::max<Int64>(elapsed.asMicroseconds(), 0);
+
+	UInt32 steps = 0;
+	while (_accumulator >= _step && steps < _maxCatchUpSteps)
+	{
+		tick(sf::microseconds(_step));
+		_accumulator -= _step;
+		++steps;
+	}
+
+	if (_accumulator >= _step)
+	{
+		_droppedTime += _accumulator - _accumulator % _step;
+		_accumulator %= _step;
+	}
+
+	_alpha = static_cast<float>(_accumulator) / static_cast<float>(_step);
+	return steps;
+}
+
+void GameController::setSimulationRate(UInt32 ticksPerSecond)
+{
+	_step = 1000000 / std::max<UInt32>(ticksPerSecond, 1);
+	_accumulator = std::min(_accumulator, _step - 1);
+}
+
+void GameController::releaseScene()
+{
+	_sleepers.clear();
+	_commands.flush(_objects);
+
+	_events.unsubscribeOwned();
+
+	// Containers live in the scene pool, so the registry is rebuilt instead of cleared
+	_objects = GameObjectRegistry{ &_scenePool };
+	_objects.setObserver(this);
+	_spatial.clear();
+	_scenePool.release();
+	_sceneArena.release();
+}
+
+void GameController::tick(const sf::Time& delta)
+{
+	_sleepers.advance(delta, _objects);
+	_objects.update(delta, _jobs);
+	_commands.flush(_objects);
+	_objects.syncSpatialIndex(_spatial);
+	_sleepers.wakeNearSources(_spatial);
+	++_ticks;
+}
+
+void GameController::render(sf::RenderTarget& canvas, float alpha)
+{
+	_objects.renderVisible(canvas, _batch, _spatial, alpha, &_frameArena);
+}
+
+void GameController::_pollEvents()
+{
+	sf::Event event;
+	while (_window.pollEvent(event))
+	{
+		if (event.type == sf::Event::Closed)
+			stop();
+		_events.post(event);
+	}
+	_events.dispatch();
+}
+
+void GameController::onGameObjectDestroyed(UniqueId uid)
+{
+	_spatial.remove(uid);
+	_sleepers.drop(uid);
+	_events.unsubscribeOwner(uid);
+}
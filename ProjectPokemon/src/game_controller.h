@@ -0,0 +1,122 @@
+#pragma once
+
+#include "game_basics.h"
+#include "arena.h"
+#include "events.h"
+#include "wake_scheduler.h"
+#include "async_loader.h"
+#include "hot_reload.h"
+
+class GameController : private GameObjectObserver
+{
+public:
+	static constexpr UInt32 default_simulation_rate = 60;
+	static constexpr UInt32 default_max_catch_up_steps = 5;
+	static constexpr Size scene_pool_largest_block = 4 * 1024 * 1024;
+
+private:
+	sf::RenderWindow _window;
+	JobSystem _jobs;
+	FrameArena _frameArena;
+	SceneArena _sceneArena;
+	/* Recycles container blocks on top of the scene arena, which never frees */
+	std::pmr::unsynchronized_pool_resource _scenePool;
+	ResourceManager _resources;
+	AsyncLoader _loader;
+	HotReloader _reloader;
+	GameObjectRegistry _objects;
+	GameObjectCommandQueue _commands;
+	EventRouter _events;
+	WakeScheduler _sleepers;
+	SpatialGrid _spatial;
+	SpriteBatch _batch;
+
+	Int64 _step = 1000000 / default_simulation_rate;
+	Int64 _accumulator = 0;
+	Int64 _droppedTime = 0;
+	UInt32 _maxCatchUpSteps = default_max_catch_up_steps;
+	Int64 _loadBudget = AsyncLoader::default_budget_us;
+	float _alpha = 0;
+	UInt64 _ticks = 0;
+	bool _running = false;
+
+public:
+	GameController();
+	virtual ~GameController() = default;
+
+	GameController(const GameController&) = delete;
+	GameController(GameController&&) = delete;
+
+	GameController& operator= (const GameController&) = delete;
+	GameController& operator= (GameController&&) = delete;
+
+public:
+	void open(const sf::VideoMode& mode, const String& title, UInt32 style = sf::Style::Default);
+
+	int run();
+	inline void stop() { _running = false; }
+	inline bool isRunning() const { return _running; }
+
+	UInt32 advance(const sf::Time& elapsed);
+
+	void setSimulationRate(UInt32 ticksPerSecond);
+	inline UInt32 simulationRate() const { return static_cast<UInt32>(1000000 / _step); }
+	inline sf::Time simulationStep() const { return sf::microseconds(_step); }
+
+	inline void setRenderRate(UInt32 framesPerSecond) { _window.setFramerateLimit(framesPerSecond); }
+	inline void setVerticalSyncEnabled(bool enabled) { _window.setVerticalSyncEnabled(enabled); }
+
+	inline void setMaxCatchUpSteps(UInt32 steps) { _maxCatchUpSteps = std::max<UInt32>(steps, 1); }
+	inline UInt32 maxCatchUpSteps() const { return _maxCatchUpSteps; }
+
+	inline float interpolationAlpha() const { return _alpha; }
+	inline UInt64 ticks() const { return _ticks; }
+	inline sf::Time droppedTime() const { return sf::microseconds(_droppedTime); }
+
+	inline void setLoadBudget(const sf::Time& budget) { _loadBudget = std::max<Int64>(budget.asMicroseconds(), 0); }
+	inline sf::Time loadBudget() const { return sf::microseconds(_loadBudget); }
+
+	inline sf::RenderWindow& window() { return _window; }
+	inline JobSystem& jobs() { return _jobs; }
+	inline GameObjectRegistry& objects() { return _objects; }
+	inline GameObjectCommandQueue& commands() { return _commands; }
+	inline EventRouter& events() { return _events; }
+	inline WakeScheduler& sleepers() { return _sleepers; }
+	inline SpriteBatch& batch() { return _batch; }
+	inline SpatialGrid& spatialIndex() { return _spatial; }
+	inline FrameArena& frameArena() { return _frameArena; }
+	inline SceneArena& sceneArena() { return _sceneArena; }
+	inline ResourceManager& resources() { return _resources; }
+	inline AsyncLoader& loader() { return _loader; }
+	inline HotReloader& reloader() { return _reloader; }
+
+	/* Drops every game object and the scene arena; references into objects() do not survive it */
+	void releaseScene();
+
+	template<std::derived_from<GameObject> _Ty, typename... _Args>
+	SlotHandle spawn(_Args&&... args)
+	{
+		GameObjectContainer<_Ty>& container = _objects.container<_Ty>();
+		SlotHandle handle = container.emplaceGameObject(std::forward<_Args>(args)...);
+		if (handle)
+			container.getGameObject(handle)->_gc = this;
+		return handle;
+	}
+
+	template<std::derived_from<GameObject> _Ty, typename... _Args>
+	UniqueId spawnDeferred(_Args&&... args)
+	{
+		_Ty& obj = _commands.local().stage<_Ty>(std::forward<_Args>(args)...);
+		obj._gc = this;
+		return obj.uid();
+	}
+
+protected:
+	virtual void tick(const sf::Time& delta);
+	virtual void render(sf::RenderTarget& canvas, float alpha);
+
+private:
+	void _pollEvents();
+
+	void onGameObjectDestroyed(UniqueId uid) override;
+};
@@ -0,0 +1,261 @@
+#include "hot_reload.h"
+#include "vfs.h"
+
+#ifdef __linux__
+#	include <sys/inotify.h>
+#	include <unistd.h>
+#endif
+
+namespace
+{
+#ifdef __linux__
+	constexpr UInt32 watch_mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE;
+#endif
+}
+
+FileWatcher::~FileWatcher() { close(); }
+
+Size FileWatcher::watch(const Path& directory)
+{
+#ifdef __linux__
+	std::error_code error;
+	if (!filesystem::is_directory(directory, error))
+		return npos;
+
+	if (_fd < 0)
+	{
+		_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (_fd < 0)
+			return npos;
+	}
+
+	Size root = _roots.size();
+	_roots.push_back(directory);
+	_watchTree(root, {}, nullptr);
+	return root;
+#else
+	return npos;
+#endif
+}
+
+void FileWatcher::close()
+{
+#ifdef __linux__
+	if (_fd >= 0)
+		::close(_fd);
+#endif
+
+	_fd = -1;
+	_roots.clear();
+	_watches.clear();
+}
+
+Size FileWatcher::poll(std::vector<FileChange>& changes)
+{
+	Size count = changes.size();
+
+#ifdef __linux__
+	if (_fd < 0)
+		return 0;
+
+	alignas(inotify_event) char buffer[4096];
+	bool overflowed = false;
+	for (;;)
+	{
+		ssize_t length = ::read(_fd, buffer, sizeof(buffer));
+		if (length <= 0)
+			break;
+
+		for (char* ptr = buffer; ptr < buffer + length;)
+		{
+			const inotify_event* event = reinterpret_cast<const inotify_event*>(ptr);
+			ptr += sizeof(inotify_event) + event->len;
+
+			if (event->mask & IN_Q_OVERFLOW)
+			{
+				++_overflows, overflowed = true;
+				continue;
+			}
+
+			auto it = _watches.find(event->wd);
+			if (it == _watches.end())
+				continue;
+			if (event->mask & IN_IGNORED)
+			{
+				_watches.erase(it);
+				continue;
+			}
+			if (event->len == 0)
+				continue;
+
+			Size root = it->second.root;
+			Path path = it->second.path / event->name;
+
+			/* Directories moved or created in are watched too, and the files already inside count as changed */
+			if (event->mask & IN_ISDIR)
+			{
+				if (event->mask & (IN_CREATE | IN_MOVED_TO))
+					_watchTree(root, path, &changes);
+			}
+			else changes.push_back({ root, std::move(path) });
+		}
+	}
+
+	/* Dropped events may hide any edit, so every file counts as changed and directories missed are watched */
+	if (overflowed)
+		for (Size root = 0; root < _roots.size(); ++root)
+			_watchTree(root, {}, &changes);
+#endif
+
+	return changes.size() - count;
+}
+
+void FileWatcher::_watchTree(Size root, const Path& relative, std::vector<FileChange>* created)
+{
+#ifdef __linux__
+	const Path& base = _roots[root];
+	int wd = inotify_add_watch(_fd, (base / relative).c_str(), watch_mask | IN_ONLYDIR);
+	if (wd < 0)
+		return;
+	_watches.insert_or_assign(wd, Watch{ root, relative });
+
+	std::error_code error;
+	for (filesystem::directory_iterator it{ base / relative, error }, end; !error && it != end; it.increment(error))
+	{
+		Path path = relative / it->path().filename();
+		if (it->is_directory(error))
+			_watchTree(root, path, created);
+		else if (created)
+			created->push_back({ root, std::move(path) });
+	}
+#endif
+}
+
+
+
+HotReloader::HotReloader(ResourceManager& resources, AsyncLoader& loader) :
+	_resources{ resources },
+	_loader{ loader }
+{}
+
+bool HotReloader::enable()
+{
+	if (_enabled)
+		return true;
+	if constexpr (!FileWatcher::supported)
+		return false;
+
+	const ResourceFolder& root = _resources.root();
+	bool watching = false;
+	if (root.isVirtual())
+	{
+		/* Mount directories are watched as the root of the virtual tree */
+		for (const auto& mount : root.vfs()->mounts())
+			if (!mount.folder->isPacked() && !mount.folder->isVirtual())
+				watching |= _watcher.watch(mount.folder->path()) != FileWatcher::npos;
+	}
+	else if (!root.isPacked())
+		watching = _watcher.watch(root.path()) != FileWatcher::npos;
+
+	if (!watching)
+	{
+		_watcher.close();
+		return false;
+	}
+
+	_clock.restart();
+	_enabled = true;
+	return true;
+}
+
+void HotReloader::disable()
+{
+	_watcher.close();
+	_changes.clear();
+	_pending.clear();
+	_enabled = false;
+}
+
+Size HotReloader::update()
+{
+	if (!_enabled)
+		return 0;
+
+	Int64 now = _clock.getElapsedTime().asMicroseconds();
+	const ResourceFolder& root = _resources.root();
+
+	_changes.clear();
+	_watcher.poll(_changes);
+	for (const FileChange& change : _changes)
+	{
+		Path path = root.isVirtual() && !root.path().empty() ? change.path.lexically_relative(root.path()) : change.path;
+		String name = path.lexically_normal().generic_string();
+		if (!name.empty() && !name.starts_with(".."))
+			_pending.insert_or_assign(Symbol{ name }, now);
+	}
+
+	if (_pending.empty())
+		return 0;
+
+	std::vector<Symbol> settled;
+	for (const auto& entry : _pending)
+		if (now - entry.second >= _debounce)
+			settled.push_back(entry.first);
+	if (settled.empty())
+		return 0;
+
+	/* Added or removed files can change which mount a path resolves to */
+	if (root.isVirtual())
+		root.vfs()->invalidate();
+
+	Size count = 0;
+	for (Symbol path : settled)
+	{
+		_pending.erase(path);
+		count += _reload(path);
+	}
+	return count;
+}
+
+SlotHandle HotReloader::subscribe(Listener listener, Symbol key)
+{
+	return _subscriptions.emplace(Subscription{ std::move(listener), key });
+}
+
+bool HotReloader::unsubscribe(SlotHandle subscription)
+{
+	return _subscriptions.erase(subscription);
+}
+
+Size HotReloader::_reload(Symbol path)
+{
+	Symbol key = _resources.root().keyOf(path);
+	Size count = 0;
+
+	/* Only resources that are actually loaded are worth reloading */
+	_resources.forEachCache([this, path, key, &count](auto& cache) {
+		using Resource = typename std::remove_reference_t<decltype(cache)>::value_type;
+		if (!cache.contains(key))
+			return;
+
+		++count;
+		_loader.reload<Resource>(Path{ path.view() }, [this, key](const ResourceHandle<Resource>& handle) {
+			if (!handle)
+				++_failed;
+			else ++_reloaded, _notify(key, typeid(Resource));
+		});
+	});
+	return count;
+}
+
+void HotReloader::_notify(Symbol key, std::type_index type)
+{
+	/* Copied so listeners can unsubscribe while being notified */
+	std::vector<Listener> listeners;
+	for (const Subscription& subscription : _subscriptions)
+		if (!subscription.key || subscription.key == key)
+			listeners.push_back(subscription.listener);
+
+	for (const Listener& listener : listeners)
+		listener(key, type);
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "common.h"
+#include "slot_map.h"
+#include "async_loader.h"
+
+struct FileChange
+{
+	Size root;
+	Path path;
+};
+
+/*
+ * Recursive directory watcher polled without blocking. Backed by inotify on
+ * Linux; elsewhere watch() fails and the watcher stays idle. Nothing is
+ * allocated and no descriptor is opened until the first watch().
+ */
+class FileWatcher
+{
+public:
+	static constexpr bool supported =
+#ifdef __linux__
+		true;
+#else
+		false;
+#endif
+
+	static constexpr Size npos = ~Size(0);
+
+private:
+	struct Watch
+	{
+		Size root;
+		Path path;
+	};
+
+	int _fd = -1;
+	std::vector<Path> _roots;
+	FlatHashMap<int, Watch> _watches;
+	Size _overflows = 0;
+
+public:
+	FileWatcher() = default;
+	~FileWatcher();
+
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher(FileWatcher&&) = delete;
+
+	FileWatcher& operator= (const FileWatcher&) = delete;
+	FileWatcher& operator= (FileWatcher&&) = delete;
+
+public:
+	/* Returns the index reported as FileChange::root, or npos when the directory cannot be watched */
+	Size watch(const Path& directory);
+	void close();
+
+	/* Appends the files changed since the last poll, relative to their root; every file when the event queue overflowed */
+	Size poll(std::vector<FileChange>& changes);
+
+	inline bool isWatching() const { return _fd >= 0; }
+	inline Size rootCount() const { return _roots.size(); }
+	inline Size watchCount() const { return _watches.size(); }
+	inline Size overflowCount() const { return _overflows; }
+
+private:
+	void _watchTree(Size root, const Path& relative, std::vector<FileChange>* created);
+};
+
+
+
+/*
+ * Picks up edited resources while the game runs. Changes under the disk
+ * directories behind the ResourceManager root are coalesced per file until
+ * they settle for the debounce time, then every cache holding that file
+ * reloads it in the background through the AsyncLoader. The new value
+ * replaces the old one behind the existing handles on the main thread, and
+ * listeners are told once it did. While disabled no file is watched and
+ * update() is never needed.
+ */
+class HotReloader
+{
+public:
+	typedef Function<void(Symbol key, std::type_index type)> Listener;
+
+	static constexpr Int64 default_debounce_us = 150000;
+
+private:
+	struct Subscription
+	{
+		Listener listener;
+		Symbol key;
+	};
+
+	ResourceManager& _resources;
+	AsyncLoader& _loader;
+	FileWatcher _watcher;
+	std::vector<FileChange> _changes;
+	FlatHashMap<Symbol, Int64, Symbol::hash> _pending;
+	SlotMap<Subscription> _subscriptions;
+	sf::Clock _clock;
+	Int64 _debounce = default_debounce_us;
+	Size _reloaded = 0;
+	Size _failed = 0;
+	bool _enabled = false;
+
+public:
+	HotReloader(ResourceManager& resources, AsyncLoader& loader);
+	~HotReloader() = default;
+
+	HotReloader(const HotReloader&) = delete;
+	HotReloader(HotReloader&&) = delete;
+
+	HotReloader& operator= (const HotReloader&) = delete;
+	HotReloader& operator= (HotReloader&&) = delete;
+
+public:
+	/* Starts watching the current root; mounts added later need a disable() and enable() */
+	bool enable();
+	void disable();
+	inline bool isEnabled() const { return _enabled; }
+
+	inline void setDebounce(const sf::Time& debounce) { _debounce = std::max<Int64>(debounce.asMicroseconds(), 0); }
+	inline sf::Time debounce() const { return sf::microseconds(_debounce); }
+
+	/* Main thread, once per frame while enabled; returns the number of reloads started */
+	Size update();
+
+	/* Listens to reloads of one resource, or of all of them for an empty key */
+	SlotHandle subscribe(Listener listener, Symbol key = {});
+	bool unsubscribe(SlotHandle subscription);
+
+	inline Size pendingCount() const { return _pending.size(); }
+	inline Size reloadedCount() const { return _reloaded; }
+	inline Size failedCount() const { return _failed; }
+
+private:
+	Size _reload(Symbol path);
+	void _notify(Symbol key, std::type_index type);
+};
@@ -0,0 +1,238 @@
+#include "jobs.h"
+
+struct JobHandle::Job
+{
+	Function<void()> task;
+	std::atomic<Size> unfinished = 1;
+	std::atomic<bool> done = false;
+	std::mutex mutex;
+	std::vector<ref<Job>> continuations;
+	std::exception_ptr error;
+};
+
+namespace
+{
+	thread_local const JobSystem* current_system = nullptr;
+	thread_local Size current_worker = 0;
+}
+
+bool JobHandle::done() const { return !_job || _job->done.load(std::memory_order_acquire); }
+
+
+
+JobSystem::JobSystem(Size workers)
+{
+	for (Size i = 0; i <= workers; ++i)
+		_queues.emplace_back(new WorkerQueue());
+
+	_workers.reserve(workers);
+	for (Size i = 0; i < workers; ++i)
+		_workers.emplace_back(&JobSystem::_workerMain, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::scoped_lock lock{ _sleepMutex };
+		_running = false;
+	}
+	_wake.notify_all();
+
+	for (std::thread& worker : _workers)
+		worker.join();
+}
+
+Size JobSystem::defaultWorkerCount()
+{
+	Size hw = std::thread::hardware_concurrency();
+	return hw > 1 ? hw - 1 : 0;
+}
+
+JobHandle JobSystem::schedule(Function<void()> task, std::initializer_list<JobHandle> dependencies)
+{
+	return _schedule(std::move(task), dependencies.begin(), dependencies.size());
+}
+
+JobHandle JobSystem::schedule(Function<void()> task, const std::vector<JobHandle>& dependencies)
+{
+	return _schedule(std::move(task), dependencies.data(), dependencies.size());
+}
+
+void JobSystem::wait(const JobHandle& job)
+{
+	_help(job);
+	if (job._job && job._job->error)
+		std::rethrow_exception(job._job->error);
+}
+
+void JobSystem::waitAll(const std::vector<JobHandle>& jobs)
+{
+	for (const JobHandle& job : jobs)
+		_help(job);
+
+	for (const JobHandle& job : jobs)
+		if (job._job && job._job->error)
+			std::rethrow_exception(job._job->error);
+}
+
+void JobSystem::parallelFor(Size count, Size grain, const Function<void(Size, Size)>& body)
+{
+	grain = std::max<Size>(grain, 1);
+	if (count <= grain || _workers.empty())
+	{
+		if (count > 0)
+			body(0, count);
+		return;
+	}
+
+	std::vector<JobHandle> chunks;
+	chunks.reserve((count + grain - 1) / grain);
+	for (Size begin = grain; begin < count; begin += grain)
+	{
+		Size end = std::min(begin + grain, count);
+		chunks.push_back(schedule([&body, begin, end]() { body(begin, end); }));
+	}
+
+	try { body(0, grain); }
+	catch (...)
+	{
+		for (const JobHandle& chunk : chunks)
+			_help(chunk);
+		throw;
+	}
+	waitAll(chunks);
+}
+
+JobHandle JobSystem::_schedule(Function<void()>&& task, const JobHandle* deps, Size depCount)
+{
+	auto job = std::allocate_shared<JobHandle::Job>(PoolAllocator<JobHandle::Job>());
+	job->task = std::move(task);
+
+	for (Size i = 0; i < depCount; ++i)
+	{
+		const ref<JobHandle::Job>& dep = deps[i]._job;
+		if (!dep)
+			continue;
+
+		std::scoped_lock lock{ dep->mutex };
+		if (!dep->done.load(std::memory_order_relaxed))
+		{
+			dep->continuations.push_back(job);
+			job->unfinished.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	_release(job);
+	return job;
+}
+
+void JobSystem::_help(const JobHandle& job)
+{
+	while (!job.done())
+		if (!_runOne())
+			std::this_thread::yield();
+}
+
+void JobSystem::_release(const ref<JobHandle::Job>& job)
+{
+	if (job->unfinished.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		_push(job);
+}
+
+void JobSystem::_push(const ref<JobHandle::Job>& job)
+{
+	Size index = current_system == this ? current_worker : _workers.size();
+	{
+		std::scoped_lock lock{ _sleepMutex };
+		_pending.fetch_add(1, std::memory_order_release);
+	}
+
+	{
+		WorkerQueue& queue = *_queues[index];
+		std::scoped_lock lock{ queue.mutex };
+		queue.jobs.push_back(job);
+	}
+	_wake.notify_one();
+}
+
+ref<JobHandle::Job> JobSystem::_pop()
+{
+	if (_pending.load(std::memory_order_acquire) == 0)
+		return nullptr;
+
+	Size self = current_system == this ? current_worker : _workers.size();
+	{
+		WorkerQueue& queue = *_queues[self];
+		std::scoped_lock lock{ queue.mutex };
+		if (!queue.jobs.empty())
+		{
+			ref<JobHandle::Job> job = std::move(queue.jobs.back());
+			queue.jobs.pop_back();
+			_pending.fetch_sub(1, std::memory_order_relaxed);
+			return job;
+		}
+	}
+
+	Size count = _queues.size();
+	Size start = _nextQueue.fetch_add(1, std::memory_order_relaxed);
+	for (Size i = 0; i < count; ++i)
+	{
+		Size victim = (start + i) % count;
+		if (victim == self)
+			continue;
+
+		WorkerQueue& queue = *_queues[victim];
+		std::scoped_lock lock{ queue.mutex };
+		if (!queue.jobs.empty())
+		{
+			ref<JobHandle::Job> job = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+			_pending.fetch_sub(1, std::memory_order_relaxed);
+			return job;
+		}
+	}
+
+	return nullptr;
+}
+
+bool JobSystem::_runOne()
+{
+	ref<JobHandle::Job> job = _pop();
+	if (!job)
+		return false;
+
+	_execute(job);
+	return true;
+}
+
+void JobSystem::_execute(const ref<JobHandle::Job>& job)
+{
+	try { job->task(); }
+	catch (...) { job->error = std::current_exception(); }
+	job->task = nullptr;
+
+	std::vector<ref<JobHandle::Job>> continuations;
+	{
+		std::scoped_lock lock{ job->mutex };
+		job->done.store(true, std::memory_order_release);
+		continuations.swap(job->continuations);
+	}
+
+	for (const auto& next : continuations)
+		_release(next);
+}
+
+void JobSystem::_workerMain(Size index)
+{
+	current_system = this;
+	current_worker = index;
+
+	while (_running.load(std::memory_order_acquire))
+	{
+		if (_runOne())
+			continue;
+
+		std::unique_lock lock{ _sleepMutex };
+		_wake.wait(lock, [this]() { return _pending.load(std::memory_order_acquire) > 0 || !_running.load(std::memory_order_acquire); });
+	}
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "common.h"
+#include "pool.h"
+
+class JobSystem;
+
+class JobHandle
+{
+public:
+	struct Job;
+
+private:
+	ref<Job> _job;
+
+public:
+	JobHandle() = default;
+	JobHandle(const JobHandle&) = default;
+	JobHandle(JobHandle&&) noexcept = default;
+	~JobHandle() = default;
+
+	JobHandle& operator= (const JobHandle&) = default;
+	JobHandle& operator= (JobHandle&&) noexcept = default;
+
+	inline bool operator== (const JobHandle&) const = default;
+
+	inline operator bool() const { return static_cast<bool>(_job); }
+	inline bool operator! () const { return !_job; }
+
+	bool done() const;
+
+private:
+	inline JobHandle(const ref<Job>& job) : _job{ job } {}
+
+public:
+	friend class JobSystem;
+};
+
+
+
+class JobSystem
+{
+private:
+	struct WorkerQueue
+	{
+		std::mutex mutex;
+		std::deque<ref<JobHandle::Job>> jobs;
+	};
+
+	std::vector<std::thread> _workers;
+	std::vector<uref<WorkerQueue>> _queues;
+	std::atomic<Size> _pending = 0;
+	std::atomic<Size> _nextQueue = 0;
+	std::atomic<bool> _running = true;
+	std::mutex _sleepMutex;
+	std::condition_variable _wake;
+
+public:
+	explicit JobSystem(Size workers = defaultWorkerCount());
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator= (const JobSystem&) = delete;
+
+	inline Size workerCount() const { return _workers.size(); }
+
+	JobHandle schedule(Function<void()> task, std::initializer_list<JobHandle> dependencies = {});
+	JobHandle schedule(Function<void()> task, const std::vector<JobHandle>& dependencies);
+
+	void wait(const JobHandle& job);
+	void waitAll(const std::vector<JobHandle>& jobs);
+
+	void parallelFor(Size count, Size grain, const Function<void(Size, Size)>& body);
+
+	template<std::ranges::random_access_range _Range, typename _Fty>
+	void parallelForEach(_Range&& range, Size grain, _Fty&& action)
+	{
+		auto first = std::ranges::begin(range);
+		parallelFor(static_cast<Size>(std::ranges::size(range)), grain, [first, &action](Size begin, Size end) {
+			for (Size i = begin; i < end; ++i)
+				action(first[i]);
+		});
+	}
+
+	static Size defaultWorkerCount();
+
+private:
+	JobHandle _schedule(Function<void()>&& task, const JobHandle* deps, Size depCount);
+	void _help(const JobHandle& job);
+	void _release(const ref<JobHandle::Job>& job);
+	void _push(const ref<JobHandle::Job>& job);
+	ref<JobHandle::Job> _pop();
+	bool _runOne();
+	void _execute(const ref<JobHandle::Job>& job);
+	void _workerMain(Size index);
+};
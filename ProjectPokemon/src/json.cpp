@@ -13,6 +13,26 @@ namespace utils
 		catch (const std::exception& ex) { throw JsonException{ ex.what() }; }
 	}
 
+	/*
+	 * Slurps the stream into a buffer taken from the given resource and parses
+	 * from memory, which avoids the per character stream overhead.
+	 */
+	Json read(std::istream& input, std::pmr::memory_resource* resource)
+	{
+		std::pmr::string buffer{ resource };
+		buffer.assign(std::istreambuf_iterator<char>{ input }, std::istreambuf_iterator<char>{});
+		return parse(buffer);
+	}
+
+	Json parse(std::string_view text)
+	{
+		try
+		{
+			return Json::parse(text.begin(), text.end());
+		}
+		catch (const std::exception& ex) { throw JsonException{ ex.what() }; }
+	}
+
 	Json read(const Path& path)
 	{
 		std::fstream f{ path, std::ios::in };
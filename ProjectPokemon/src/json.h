@@ -1,6 +1,7 @@
 #pragma once
 
 #include "common.h"
+#include "symbol.h"
 
 namespace utils
 {
@@ -25,6 +26,8 @@ namespace utils
 	concept JsonSerializableOnly = std::derived_from<_Ty, JsonSerializable>;
 
 	Json read(std::istream& input);
+	Json read(std::istream& input, std::pmr::memory_resource* resource);
+	Json parse(std::string_view text);
 	Json read(const Path& path);
 	Json read(const String& path);
 
@@ -44,24 +47,38 @@ namespace utils
 	inline void write(const Path& path, const JsonSerializable& obj) { write(path, obj.serialize()); }
 	inline void write(const String& path, const JsonSerializable& obj) { write(path, obj.serialize()); }
 
-	inline bool has(const Json& json, const char* key) { return json.find(key) != json.end(); }
-	inline bool has(const Json& json, const String& key) { return json.find(key) != json.end(); }
+	inline bool has(const Json& json, std::string_view key) { return json.find(key) != json.end(); }
+	inline bool has(const Json& json, Symbol key) { return json.find(key.view()) != json.end(); }
 
 	template<typename _Ty>
-	const _Ty& opt(const Json& json, const String& key, const _Ty& default_value)
+	const _Ty& opt(const Json& json, std::string_view key, const _Ty& default_value)
 	{
 		const auto it = json.find(key);
 		return it == json.end() ? default_value : it.value().get_ref<_Ty>();
 	}
 
 	template<typename _Ty>
-	const _Ty* opt(const Json& json, const String& key)
+	const _Ty* opt(const Json& json, std::string_view key)
 	{
 		const auto it = json.find(key);
 		if (it == json.end())
 			return nullptr;
 		return std::addressof<_Ty>(it.value().get_ref<_Ty>());
 	}
+
+	template<typename _Ty>
+	inline const _Ty& opt(const Json& json, Symbol key, const _Ty& default_value) { return opt<_Ty>(json, key.view(), default_value); }
+
+	template<typename _Ty>
+	inline const _Ty* opt(const Json& json, Symbol key) { return opt<_Ty>(json, key.view()); }
+
+	inline Symbol opt_symbol(const Json& json, std::string_view key)
+	{
+		const auto it = json.find(key);
+		return it == json.end() || !it->is_string() ? Symbol{} : Symbol{ it->get_ref<const String&>() };
+	}
+
+	inline Symbol opt_symbol(const Json& json, Symbol key) { return opt_symbol(json, key.view()); }
 }
 
 std::ostream& operator<< (std::ostream& left, const utils::JsonSerializable& right);
@@ -0,0 +1,191 @@
+#include "pool.h"
+
+PoolStats& PoolStats::operator+= (const PoolStats& right)
+{
+	allocations += right.allocations;
+	deallocations += right.deallocations;
+	live += right.live;
+	peak += right.peak;
+	recycled += right.recycled;
+	chunks += right.chunks;
+	reservedBytes += right.reservedBytes;
+	fallbacks += right.fallbacks;
+	return *this;
+}
+
+
+
+FixedPool::FixedPool(Size blockSize, Size blocksPerChunk) :
+	_blockSize{ roundSize(blockSize) },
+	_blocksPerChunk{ std::max<Size>(blocksPerChunk, 1) }
+{}
+
+FixedPool::FixedPool(FixedPool&& other) noexcept :
+	_blockSize{ other._blockSize },
+	_blocksPerChunk{ other._blocksPerChunk },
+	_chunks{ std::move(other._chunks) },
+	_free{ std::exchange(other._free, nullptr) },
+	_stats{ std::exchange(other._stats, {}) }
+{}
+
+FixedPool::~FixedPool()
+{
+	release();
+}
+
+FixedPool& FixedPool::operator= (FixedPool&& right) noexcept
+{
+	if (this != &right)
+	{
+		release();
+		_blockSize = right._blockSize;
+		_blocksPerChunk = right._blocksPerChunk;
+		_chunks = std::move(right._chunks);
+		_free = std::exchange(right._free, nullptr);
+		_stats = std::exchange(right._stats, {});
+	}
+	return *this;
+}
+
+void* FixedPool::allocate()
+{
+	if (!_free)
+		_grow(_blocksPerChunk);
+
+	FreeBlock* block = _free;
+	_free = block->next;
+
+	++_stats.allocations;
+	_stats.peak = std::max(_stats.peak, ++_stats.live);
+	return block;
+}
+
+void FixedPool::deallocate(void* ptr)
+{
+	if (!ptr)
+		return;
+
+	FreeBlock* block = static_cast<FreeBlock*>(ptr);
+	block->next = _free;
+	_free = block;
+
+	++_stats.deallocations;
+	--_stats.live;
+}
+
+void FixedPool::reserve(Size blocks)
+{
+	Size available = _stats.chunks * _blocksPerChunk - _stats.live;
+	if (blocks > available)
+		_grow(blocks - available);
+}
+
+void FixedPool::release()
+{
+	for (void* chunk : _chunks)
+		utils::raw_free(chunk);
+
+	_chunks.clear();
+	_free = nullptr;
+	_stats.chunks = 0;
+	_stats.reservedBytes = 0;
+	_stats.live = 0;
+}
+
+void FixedPool::_grow(Size blocks)
+{
+	Size chunkBlocks = ((blocks + _blocksPerChunk - 1) / _blocksPerChunk) * _blocksPerChunk;
+	Size bytes = chunkBlocks * _blockSize;
+	char* chunk = utils::raw_malloc<char>(bytes);
+	_chunks.push_back(chunk);
+
+	for (Size i = chunkBlocks; i > 0; --i)
+	{
+		FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk + (i - 1) * _blockSize);
+		block->next = _free;
+		_free = block;
+	}
+
+	_stats.chunks += chunkBlocks / _blocksPerChunk;
+	_stats.reservedBytes += bytes;
+}
+
+
+
+SizeClassPool::SizeClassPool(Size blocksPerChunk)
+{
+	for (Offset i = 0; i < class_count; ++i)
+		_classes[i].reset(new SizeClass{ {}, FixedPool{ min_class_size << i, blocksPerChunk } });
+}
+
+void* SizeClassPool::allocate(Size size)
+{
+	if (size > max_class_size)
+	{
+		void* ptr = utils::raw_malloc<void>(size);
+		std::scoped_lock lock{ _fallbackMutex };
+		++_fallback.allocations, ++_fallback.fallbacks;
+		_fallback.peak = std::max(_fallback.peak, ++_fallback.live);
+		return ptr;
+	}
+
+	SizeClass& sizeClass = *_classes[classOf(size)];
+	std::scoped_lock lock{ sizeClass.mutex };
+	return sizeClass.pool.allocate();
+}
+
+void SizeClassPool::deallocate(void* ptr, Size size)
+{
+	if (size > max_class_size)
+	{
+		utils::raw_free(ptr);
+		std::scoped_lock lock{ _fallbackMutex };
+		++_fallback.deallocations, --_fallback.live;
+		return;
+	}
+
+	SizeClass& sizeClass = *_classes[classOf(size)];
+	std::scoped_lock lock{ sizeClass.mutex };
+	sizeClass.pool.deallocate(ptr);
+}
+
+void SizeClassPool::release()
+{
+	for (auto& sizeClass : _classes)
+	{
+		std::scoped_lock lock{ sizeClass->mutex };
+		sizeClass->pool.release();
+	}
+}
+
+PoolStats SizeClassPool::stats() const
+{
+	PoolStats result;
+	for (const auto& sizeClass : _classes)
+	{
+		std::scoped_lock lock{ sizeClass->mutex };
+		result += sizeClass->pool.stats();
+	}
+
+	std::scoped_lock lock{ _fallbackMutex };
+	return result += _fallback;
+}
+
+PoolStats SizeClassPool::stats(Size size) const
+{
+	if (size > max_class_size)
+	{
+		std::scoped_lock lock{ _fallbackMutex };
+		return _fallback;
+	}
+
+	SizeClass& sizeClass = *_classes[classOf(size)];
+	std::scoped_lock lock{ sizeClass.mutex };
+	return sizeClass.pool.stats();
+}
+
+SizeClassPool& SizeClassPool::shared()
+{
+	static SizeClassPool* const pool = new SizeClassPool();
+	return *pool;
+}
@@ -0,0 +1,275 @@
+#pragma once
+
+#include "common.h"
+
+struct PoolStats
+{
+	Size allocations = 0;
+	Size deallocations = 0;
+	Size live = 0;
+	Size peak = 0;
+	Size recycled = 0;
+	Size chunks = 0;
+	Size reservedBytes = 0;
+	Size fallbacks = 0;
+
+	PoolStats& operator+= (const PoolStats& right);
+};
+
+template<typename _Ty, typename... _Args>
+concept Recyclable = requires(_Ty& obj, _Args&&... args) { obj.recycle(std::forward<_Args>(args)...); };
+
+
+
+/*
+ * Fixed size block allocator. Memory is requested from utils::raw_malloc in
+ * chunks and handed out through an intrusive free list; blocks are only
+ * returned to the heap by release() or the destructor.
+ */
+class FixedPool
+{
+public:
+	static constexpr Size block_alignment = alignof(std::max_align_t);
+	static constexpr Size default_blocks_per_chunk = 64;
+
+private:
+	struct FreeBlock
+	{
+		FreeBlock* next;
+	};
+
+	Size _blockSize;
+	Size _blocksPerChunk;
+	std::vector<void*> _chunks;
+	FreeBlock* _free = nullptr;
+	PoolStats _stats;
+
+public:
+	explicit FixedPool(Size blockSize, Size blocksPerChunk = default_blocks_per_chunk);
+	FixedPool(FixedPool&& other) noexcept;
+	~FixedPool();
+
+	FixedPool& operator= (FixedPool&& right) noexcept;
+
+	FixedPool(const FixedPool&) = delete;
+	FixedPool& operator= (const FixedPool&) = delete;
+
+public:
+	void* allocate();
+	void deallocate(void* ptr);
+
+	void reserve(Size blocks);
+	void release();
+
+	inline Size blockSize() const { return _blockSize; }
+	inline Size blocksPerChunk() const { return _blocksPerChunk; }
+	inline const PoolStats& stats() const { return _stats; }
+
+	static constexpr Size roundSize(Size size)
+	{
+		size = std::max(size, sizeof(FreeBlock));
+		return (size + block_alignment - 1) & ~(block_alignment - 1);
+	}
+
+private:
+	void _grow(Size blocks);
+};
+
+
+
+/*
+ * Thread safe allocator for small objects, with one FixedPool per power of
+ * two size class. Requests bigger than max_class_size go straight to the heap.
+ */
+class SizeClassPool
+{
+public:
+	static constexpr Size min_class_size = 16;
+	static constexpr Size max_class_size = 1024;
+	static constexpr Size class_count = 7;
+
+private:
+	struct SizeClass
+	{
+		std::mutex mutex;
+		FixedPool pool;
+	};
+
+	std::array<uref<SizeClass>, class_count> _classes;
+	mutable std::mutex _fallbackMutex;
+	PoolStats _fallback;
+
+public:
+	explicit SizeClassPool(Size blocksPerChunk = FixedPool::default_blocks_per_chunk);
+	~SizeClassPool() = default;
+
+	SizeClassPool(const SizeClassPool&) = delete;
+	SizeClassPool(SizeClassPool&&) = delete;
+
+	SizeClassPool& operator= (const SizeClassPool&) = delete;
+	SizeClassPool& operator= (SizeClassPool&&) = delete;
+
+public:
+	void* allocate(Size size);
+	void deallocate(void* ptr, Size size);
+
+	void release();
+
+	PoolStats stats() const;
+	PoolStats stats(Size size) const;
+
+	static SizeClassPool& shared();
+
+	static constexpr Offset classOf(Size size)
+	{
+		Offset index = 0;
+		for (Size classSize = min_class_size; classSize < size; classSize <<= 1)
+			++index;
+		return index;
+	}
+};
+
+
+
+template<typename _Ty>
+class PoolAllocator
+{
+public:
+	using value_type = _Ty;
+
+private:
+	SizeClassPool* _pool;
+
+public:
+	PoolAllocator() : _pool{ &SizeClassPool::shared() } {}
+	PoolAllocator(SizeClassPool& pool) : _pool{ &pool } {}
+	PoolAllocator(const PoolAllocator&) = default;
+	~PoolAllocator() = default;
+
+	template<typename _OtherTy>
+	PoolAllocator(const PoolAllocator<_OtherTy>& other) : _pool{ &other.pool() } {}
+
+	PoolAllocator& operator= (const PoolAllocator&) = default;
+
+	template<typename _OtherTy>
+	inline bool operator== (const PoolAllocator<_OtherTy>& right) const { return _pool == &right.pool(); }
+
+public:
+	inline SizeClassPool& pool() const { return *_pool; }
+
+	_Ty* allocate(Size count)
+	{
+		static_assert(alignof(_Ty) <= FixedPool::block_alignment, "over-aligned types are not supported");
+		if (count > std::numeric_limits<Size>::max() / sizeof(_Ty))
+			throw std::bad_array_new_length();
+		return static_cast<_Ty*>(_pool->allocate(count * sizeof(_Ty)));
+	}
+
+	inline void deallocate(_Ty* ptr, Size count) { _pool->deallocate(ptr, count * sizeof(_Ty)); }
+};
+
+
+
+/*
+ * Typed pool that can keep released objects constructed. create() reuses a
+ * recycled object through its recycle(args...) member when the type provides
+ * one for the given arguments, otherwise the object is rebuilt in place.
+ */
+template<typename _Ty>
+class ObjectPool
+{
+private:
+	FixedPool _pool;
+	std::vector<_Ty*> _recycled;
+	Size _recycleCapacity;
+	Size _reused = 0;
+
+public:
+	explicit ObjectPool(Size recycleCapacity = std::numeric_limits<Size>::max(), Size objectsPerChunk = FixedPool::default_blocks_per_chunk) :
+		_pool{ sizeof(_Ty), objectsPerChunk },
+		_recycleCapacity{ recycleCapacity }
+	{
+		static_assert(alignof(_Ty) <= FixedPool::block_alignment, "over-aligned types are not supported");
+	}
+	~ObjectPool() { shrink(); }
+
+	ObjectPool(const ObjectPool&) = delete;
+	ObjectPool(ObjectPool&&) = delete;
+
+	ObjectPool& operator= (const ObjectPool&) = delete;
+	ObjectPool& operator= (ObjectPool&&) = delete;
+
+public:
+	template<typename... _Args>
+	_Ty* create(_Args&&... args)
+	{
+		if (!_recycled.empty())
+		{
+			_Ty* obj = _recycled.back();
+			_recycled.pop_back();
+			++_reused;
+
+			if constexpr (Recyclable<_Ty, _Args...>)
+			{
+				try { obj->recycle(std::forward<_Args>(args)...); }
+				catch (...) { utils::destroy(*obj), _pool.deallocate(obj); throw; }
+				return obj;
+			}
+			else
+			{
+				utils::destroy(*obj);
+				return _construct(obj, std::forward<_Args>(args)...);
+			}
+		}
+
+		return _construct(static_cast<_Ty*>(_pool.allocate()), std::forward<_Args>(args)...);
+	}
+
+	void destroy(_Ty* obj)
+	{
+		utils::destroy(*obj);
+		_pool.deallocate(obj);
+	}
+
+	void recycle(_Ty* obj)
+	{
+		if (_recycled.size() < _recycleCapacity)
+			_recycled.push_back(obj);
+		else destroy(obj);
+	}
+
+	template<typename... _Args>
+	ref<_Ty> share(_Args&&... args)
+	{
+		_Ty* obj = create(std::forward<_Args>(args)...);
+		try { return ref<_Ty>(obj, [this](_Ty* ptr) { recycle(ptr); }); }
+		catch (...) { destroy(obj); throw; }
+	}
+
+	void shrink()
+	{
+		for (_Ty* obj : _recycled)
+			destroy(obj);
+		_recycled.clear();
+	}
+
+	inline void reserve(Size count) { _pool.reserve(count); }
+	inline void setRecycleCapacity(Size capacity) { _recycleCapacity = capacity; }
+	inline Size recycleCapacity() const { return _recycleCapacity; }
+	inline Size recycledCount() const { return _recycled.size(); }
+
+	PoolStats stats() const
+	{
+		PoolStats stats = _pool.stats();
+		stats.recycled = _reused;
+		return stats;
+	}
+
+private:
+	template<typename... _Args>
+	_Ty* _construct(_Ty* obj, _Args&&... args)
+	{
+		try { return &utils::construct(*obj, std::forward<_Args>(args)...); }
+		catch (...) { _pool.deallocate(obj); throw; }
+	}
+};
@@ -1,33 +1,83 @@
 #include "resource.h"
+#include "vfs.h"
 
 ResourceFolder::ResourceFolder(const Path& path) :
-	_path{ path }
+	_path{ path },
+	_key{ _path.lexically_normal().generic_string() }
 {}
 
 ResourceFolder::ResourceFolder(const ResourceFolder& parent, const Path& path) :
-	_path{ parent._path / path }
+	_path{ parent._path / path },
+	_key{ _path.lexically_normal().generic_string() },
+	_archive{ parent._archive },
+	_vfs{ parent._vfs }
 {}
 
+ResourceFolder::ResourceFolder(const ref<const Archive>& archive, const Path& path) :
+	_path{ path },
+	_key{ _path.lexically_normal().generic_string() },
+	_archive{ archive }
+{}
+
+ResourceFolder::ResourceFolder(const ref<const VirtualFileSystem>& vfs, const Path& path) :
+	_path{ path },
+	_key{ _path.lexically_normal().generic_string() },
+	_vfs{ vfs }
+{}
+
+const ArchiveEntry* ResourceFolder::_find(const Path& path) const
+{
+	return _archive->find(Archive::nameOf(_path / path));
+}
+
 bool ResourceFolder::_open(const String& filename, std::ifstream& stream) const
 {
+	if (_archive || _vfs)
+		return _open(Path{ filename }, stream);
+
 	stream.open(_path / filename, std::ios::in);
 	return !stream.fail();
 }
 
 bool ResourceFolder::_open(const Path& path, std::ifstream& stream) const
 {
+	if (_vfs)
+	{
+		auto resolved = _vfs->resolve(_path / path);
+		return resolved && resolved.folder->openInput(resolved.path, stream);
+	}
+	if (_archive)
+		return false;
+
 	stream.open(_path / path, std::ios::in);
 	return !stream.fail();
 }
 
 bool ResourceFolder::_open(const String& filename, std::ofstream& stream) const
 {
+	if (_archive || _vfs)
+		return _open(Path{ filename }, stream);
+
 	stream.open(_path / filename, std::ios::out);
 	return !stream.fail();
 }
 
 bool ResourceFolder::_open(const Path& path, std::ofstream& stream) const
 {
+	if (_vfs)
+	{
+		String name = VirtualFileSystem::normalize(_path / path);
+		ref<const ResourceFolder> target = _vfs->writeTarget();
+		if (name.empty() || name.starts_with("..") || !target || !target->openOutput(Path{ name }, stream))
+			return false;
+
+		/* The new file may shadow or add to what the tree resolved so far */
+		_vfs->invalidate();
+		return true;
+	}
+	if (_archive)
+		return false;
+
 	stream.open(_path / path, std::ios::out);
 	return !stream.fail();
 }
@@ -38,6 +88,9 @@ bool ResourceFolder::openInput(const Path& path, std::ifstream& input) const { r
 
 bool ResourceFolder::openInput(const String& filename, const Function<void(std::istream&)>& action) const
 {
+	if (_archive || _vfs)
+		return openInput(Path{ filename }, action);
+
 	std::ifstream stream;
 	if (_open(filename, stream))
 		return action(stream), true;
@@ -46,6 +99,20 @@ bool ResourceFolder::openInput(const String& filename, const Function<void(std::
 
 bool ResourceFolder::openInput(const Path& path, const Function<void(std::istream&)>& action) const
 {
+	if (_vfs)
+	{
+		auto resolved = _vfs->resolve(_path / path);
+		return resolved && resolved.folder->openInput(resolved.path, action);
+	}
+	if (_archive)
+	{
+		return readBytes(path, [&action](std::span<const Byte> bytes) {
+			MemoryStreamBuffer buffer{ bytes };
+			std::istream stream{ &buffer };
+			return action(stream), true;
+		});
+	}
+
 	std::ifstream stream;
 	if (_open(path, stream))
 		return action(stream), true;
@@ -76,6 +143,159 @@ bool ResourceFolder::readJson(const String& filename, Json& json) const { return
 
 bool ResourceFolder::readJson(const Path& path, Json& json) const { return openInput(path, [&json](std::istream& is) { json = utils::read(is); }); }
 
+bool ResourceFolder::readJson(const Path& path, Json& json, std::pmr::memory_resource* resource) const
+{
+	std::pmr::string text{ resource };
+	if (!readText(path, text))
+		return false;
+
+	json = utils::parse(text);
+	return true;
+}
+
+bool ResourceFolder::readBytes(const Path& path, std::pmr::vector<Byte>& bytes) const
+{
+	if (_vfs)
+	{
+		auto resolved = _vfs->resolve(_path / path);
+		return resolved && resolved.folder->readBytes(resolved.path, bytes);
+	}
+	if (_archive)
+	{
+		const ArchiveEntry* entry = _find(path);
+		return entry && _archive->read(*entry, bytes);
+	}
+
+	std::ifstream stream{ _path / path, std::ios::in | std::ios::binary | std::ios::ate };
+	if (stream.fail())
+		return false;
+
+	bytes.resize(static_cast<Size>(stream.tellg()));
+	stream.seekg(0);
+	return stream.read(reinterpret_cast<char*>(bytes.data()), bytes.size()), !stream.bad();
+}
+
+bool ResourceFolder::readBytes(const Path& path, const Function<bool(std::span<const Byte>)>& action) const
+{
+	std::span<const Byte> bytes = view(path);
+	if (!bytes.empty())
+		return action(bytes);
+
+	std::pmr::vector<Byte> buffer;
+	return readBytes(path, buffer) && action(buffer);
+}
+
+bool ResourceFolder::readText(const Path& path, std::pmr::string& text) const
+{
+	if (_vfs)
+	{
+		auto resolved = _vfs->resolve(_path / path);
+		return resolved && resolved.folder->readText(resolved.path, text);
+	}
+	if (_archive)
+	{
+		const ArchiveEntry* entry = _find(path);
+		return entry && _archive->read(*entry, text);
+	}
+
+	std::ifstream stream{ _path / path, std::ios::in | std::ios::binary | std::ios::ate };
+	if (stream.fail())
+		return false;
+
+	text.resize(static_cast<Size>(stream.tellg()));
+	stream.seekg(0);
+	return stream.read(text.data(), text.size()), !stream.bad();
+}
+
 bool ResourceFolder::writeJson(const String& filename, const Json& json) const { return openOutput(filename, [&json](std::ostream& os) { utils::write(os, json); }); }
 
 bool ResourceFolder::writeJson(const Path& path, const Json& json) const { return openOutput(path, [&json](std::ostream& os) { utils::write(os, json); }); }
+
+Symbol ResourceFolder::keyOf(const Path& path) const
+{
+	return Symbol{ (_path / path).lexically_normal().generic_string() };
+}
+
+Path ResourceFolder::pathOf(const Path& path) const
+{
+	if (_vfs)
+	{
+		auto resolved = _vfs->resolve(_path / path);
+		if (resolved)
+			return resolved.folder->pathOf(resolved.path);
+	}
+	return _path / path;
+}
+
+bool ResourceFolder::isPacked(const Path& path) const
+{
+	if (_vfs)
+	{
+		auto resolved = _vfs->resolve(_path / path);
+		return resolved && resolved.folder->isPacked(resolved.path);
+	}
+	return isPacked();
+}
+
+bool ResourceFolder::exists(const Path& path) const
+{
+	if (_vfs)
+		return _vfs->exists(_path / path);
+	if (_archive)
+		return _find(path);
+
+	std::error_code error;
+	return filesystem::is_regular_file(_path / path, error);
+}
+
+std::vector<String> ResourceFolder::list(const Path& directory) const
+{
+	if (_vfs)
+		return *_vfs->list(_path / directory);
+
+	std::vector<String> names;
+	if (_archive)
+	{
+		String prefix = VirtualFileSystem::normalize(_path / directory);
+		if (!prefix.empty())
+			prefix += '/';
+
+		for (const ArchiveEntry& entry : _archive->entries())
+		{
+			std::string_view name = _archive->nameOf(entry);
+			if (!name.starts_with(prefix))
+				continue;
+
+			name.remove_prefix(prefix.size());
+			Size slash = name.find('/');
+			names.emplace_back(slash == std::string_view::npos ? name : name.substr(0, slash + 1));
+		}
+	}
+	else
+	{
+		std::error_code error;
+		for (filesystem::directory_iterator it{ _path / directory, error }, end; !error && it != end; it.increment(error))
+		{
+			String name = it->path().filename().generic_string();
+			names.push_back(it->is_directory(error) ? name + '/' : name);
+		}
+	}
+
+	std::ranges::sort(names);
+	names.erase(std::ranges::unique(names).begin(), names.end());
+	return names;
+}
+
+std::span<const Byte> ResourceFolder::view(const Path& path) const
+{
+	if (_vfs)
+	{
+		auto resolved = _vfs->resolve(_path / path);
+		return resolved ? resolved.folder->view(resolved.path) : std::span<const Byte>{};
+	}
+	if (!_archive)
+		return {};
+
+	const ArchiveEntry* entry = _find(path);
+	return entry && !entry->isCompressed() ? _archive->view(*entry) : std::span<const Byte>{};
+}
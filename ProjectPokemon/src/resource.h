@@ -2,11 +2,23 @@
 
 #include "common.h"
 #include "json.h"
+#include "archive.h"
 
+class VirtualFileSystem;
+
+/*
+ * Directory of resources on disk, inside a packed Archive, or inside the tree
+ * of a VirtualFileSystem, depending on what it was built from. Reads go
+ * through archives and mounts transparently; writes are only available on
+ * disk, and through a VirtualFileSystem they land in its writeTarget().
+ */
 class ResourceFolder
 {
 private:
 	Path _path;
+	Symbol _key;
+	ref<const Archive> _archive;
+	ref<const VirtualFileSystem> _vfs;
 
 public:
 	ResourceFolder() = default;
@@ -22,6 +34,8 @@ public:
 
 	ResourceFolder(const Path& path);
 	ResourceFolder(const ResourceFolder& parent, const Path& path);
+	explicit ResourceFolder(const ref<const Archive>& archive, const Path& path = {});
+	explicit ResourceFolder(const ref<const VirtualFileSystem>& vfs, const Path& path = {});
 
 	bool openInput(const String& filename, std::ifstream& input) const;
 	bool openInput(const Path& path, std::ifstream& input) const;
@@ -49,6 +63,29 @@ public:
 
 	inline bool writeJson(const char* filename, const Json& json) const { return writeJson(String{ filename }, json); }
 
+	inline bool openInput(Symbol filename, std::ifstream& input) const { return openInput(Path{ filename.view() }, input); }
+	inline bool openInput(Symbol filename, const Function<void(std::istream&)>& action) const { return openInput(Path{ filename.view() }, action); }
+
+	inline bool readJson(Symbol filename, Json& json) const { return readJson(Path{ filename.view() }, json); }
+
+	bool readJson(const Path& path, Json& json, std::pmr::memory_resource* resource) const;
+	inline bool readJson(const String& filename, Json& json, std::pmr::memory_resource* resource) const { return readJson(Path{ filename }, json, resource); }
+	inline bool readJson(const char* filename, Json& json, std::pmr::memory_resource* resource) const { return readJson(Path{ filename }, json, resource); }
+	inline bool readJson(Symbol filename, Json& json, std::pmr::memory_resource* resource) const { return readJson(Path{ filename.view() }, json, resource); }
+
+	bool readBytes(const Path& path, std::pmr::vector<Byte>& bytes) const;
+	inline bool readBytes(const String& filename, std::pmr::vector<Byte>& bytes) const { return readBytes(Path{ filename }, bytes); }
+	inline bool readBytes(const char* filename, std::pmr::vector<Byte>& bytes) const { return readBytes(Path{ filename }, bytes); }
+	inline bool readBytes(Symbol filename, std::pmr::vector<Byte>& bytes) const { return readBytes(Path{ filename.view() }, bytes); }
+
+	/* Hands the whole file to action; uncompressed archive entries are passed in place without a copy */
+	bool readBytes(const Path& path, const Function<bool(std::span<const Byte>)>& action) const;
+
+	bool readText(const Path& path, std::pmr::string& text) const;
+	inline bool readText(const String& filename, std::pmr::string& text) const { return readText(Path{ filename }, text); }
+	inline bool readText(const char* filename, std::pmr::string& text) const { return readText(Path{ filename }, text); }
+	inline bool readText(Symbol filename, std::pmr::string& text) const { return readText(Path{ filename.view() }, text); }
+
 	template<utils::JsonSerializableOnly _Ty>
 	inline _Ty& readAndInject(const String& filename, _Ty& obj) const
 	{
@@ -85,17 +122,42 @@ public:
 		extractAndWrite(String{ filename }, obj);
 	}
 
-	inline Path pathOf(const String& filename) const { return _path / filename; }
-	inline Path pathOf(const Path& path) const { return _path / path; }
-	inline Path pathOf(const char* filename) const { return _path / filename; }
+	/* Through a VirtualFileSystem this is the path inside the mount that holds the file */
+	Path pathOf(const Path& path) const;
+	inline Path pathOf(const String& filename) const { return pathOf(Path{ filename }); }
+	inline Path pathOf(const char* filename) const { return pathOf(Path{ filename }); }
+	inline Path pathOf(Symbol filename) const { return pathOf(Path{ filename.view() }); }
 
 	inline ResourceFolder folder(const String& filename) const { return { *this, filename }; }
 	inline ResourceFolder folder(const Path& path) const { return { *this, path }; }
 	inline ResourceFolder folder(const char* path) const { return { *this, String{ path } }; }
+	inline ResourceFolder folder(Symbol path) const { return { *this, Path{ path.view() } }; }
 
 	inline const Path& path() const { return _path; }
+	inline Symbol key() const { return _key; }
+
+	inline bool isPacked() const { return static_cast<bool>(_archive); }
+	inline bool isVirtual() const { return static_cast<bool>(_vfs); }
+	inline const ref<const Archive>& archive() const { return _archive; }
+	inline const ref<const VirtualFileSystem>& vfs() const { return _vfs; }
+
+	/* Whether path is read out of an archive, directly or through the mount that resolves it */
+	bool isPacked(const Path& path) const;
+
+	bool exists(const Path& path) const;
+
+	/* Sorted children of a directory; subdirectories end with '/' */
+	std::vector<String> list(const Path& directory = {}) const;
+
+	/* In place bytes of an uncompressed archive entry, valid while the archive is alive; empty otherwise */
+	std::span<const Byte> view(const Path& path) const;
+
+	Symbol keyOf(const Path& path) const;
+	inline Symbol keyOf(Symbol filename) const { return keyOf(Path{ filename.view() }); }
 
 private:
+	const ArchiveEntry* _find(const Path& path) const;
+
 	bool _open(const String& filename, std::ifstream& stream) const;
 	bool _open(const Path& path, std::ifstream& stream) const;
 
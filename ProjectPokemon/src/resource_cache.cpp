@@ -0,0 +1,41 @@
+#include "resource_cache.h"
+
+ResourceStats& ResourceStats::operator+= (const ResourceStats& right)
+{
+	hits += right.hits;
+	misses += right.misses;
+	failures += right.failures;
+	evictions += right.evictions;
+	reloads += right.reloads;
+	entries += right.entries;
+	idle += right.idle;
+	return *this;
+}
+
+ResourceManager::ResourceManager(const ResourceFolder& root) :
+	_root{ root }
+{}
+
+Size ResourceManager::collect()
+{
+	return _textures.collect() + _images.collect() + _fonts.collect() + _sounds.collect() + _documents.collect();
+}
+
+ResourceStats ResourceManager::stats() const
+{
+	ResourceStats stats = _textures.stats();
+	stats += _images.stats();
+	stats += _fonts.stats();
+	stats += _sounds.stats();
+	stats += _documents.stats();
+	return stats;
+}
+
+void ResourceManager::resetStats()
+{
+	_textures.resetStats();
+	_images.resetStats();
+	_fonts.resetStats();
+	_sounds.resetStats();
+	_documents.resetStats();
+}
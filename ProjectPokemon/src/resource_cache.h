@@ -0,0 +1,400 @@
+#pragma once
+
+#include "common.h"
+#include "resource.h"
+
+struct ResourceStats
+{
+	Size hits = 0;
+	Size misses = 0;
+	Size failures = 0;
+	Size evictions = 0;
+	Size reloads = 0;
+	Size entries = 0;
+	Size idle = 0;
+
+	ResourceStats& operator+= (const ResourceStats& right);
+
+	inline float hitRate() const { return hits + misses ? static_cast<float>(hits) / static_cast<float>(hits + misses) : 0.f; }
+};
+
+template<typename _Ty>
+concept FileLoadable = requires(_Ty& resource, const std::string& filename) { { resource.loadFromFile(filename) } -> std::convertible_to<bool>; };
+
+template<typename _Ty>
+struct ResourceLoader;
+
+template<typename _Ty>
+concept MemoryLoadable = requires(_Ty& resource, const void* data, std::size_t size) { { resource.loadFromMemory(data, size) } -> std::convertible_to<bool>; };
+
+template<FileLoadable _Ty>
+struct ResourceLoader<_Ty>
+{
+	static bool load(const ResourceFolder& folder, const Path& path, _Ty& resource)
+	{
+		if (!folder.isPacked(path))
+			return resource.loadFromFile(folder.pathOf(path).string());
+
+		if constexpr (MemoryLoadable<_Ty>)
+			return folder.readBytes(path, [&resource](std::span<const Byte> bytes) { return resource.loadFromMemory(bytes.data(), bytes.size()); });
+		else return false;
+	}
+};
+
+/* Fonts keep reading from the memory they were loaded from; ArchiveWriter always stores them uncompressed */
+template<>
+struct ResourceLoader<sf::Font>
+{
+	static inline bool load(const ResourceFolder& folder, const Path& path, sf::Font& font)
+	{
+		if (!folder.isPacked(path))
+			return font.loadFromFile(folder.pathOf(path).string());
+
+		std::span<const Byte> bytes = folder.view(path);
+		return !bytes.empty() && font.loadFromMemory(bytes.data(), bytes.size());
+	}
+};
+
+template<>
+struct ResourceLoader<Json>
+{
+	static inline bool load(const ResourceFolder& folder, const Path& path, Json& json) { return folder.readJson(path, json); }
+};
+
+template<typename _Ty>
+concept Loadable = requires(const ResourceFolder& folder, const Path& path, _Ty& resource) { { ResourceLoader<_Ty>::load(folder, path, resource) } -> std::convertible_to<bool>; };
+
+template<Loadable _Ty>
+class ResourceCache;
+
+template<typename _Ty>
+struct ResourceEntry
+{
+	_Ty value;
+	Symbol key;
+	UInt32 refs = 0;
+	ResourceCache<_Ty>* cache = nullptr;
+	typename std::list<ResourceEntry*>::iterator idle;
+	bool isIdle = false;
+};
+
+
+
+/*
+ * Counted reference to a cached resource. Handles are a single pointer and
+ * must not outlive the cache that produced them.
+ */
+template<typename _Ty>
+class ResourceHandle
+{
+private:
+	ResourceEntry<_Ty>* _entry = nullptr;
+
+public:
+	constexpr ResourceHandle() = default;
+	constexpr ResourceHandle(std::nullptr_t) {}
+
+	ResourceHandle(const ResourceHandle& other) : _entry{ other._entry } { _retain(); }
+	ResourceHandle(ResourceHandle&& other) noexcept : _entry{ std::exchange(other._entry, nullptr) } {}
+	~ResourceHandle() { _release(); }
+
+	ResourceHandle& operator= (const ResourceHandle& right)
+	{
+		ResourceHandle{ right }.swap(*this);
+		return *this;
+	}
+
+	ResourceHandle& operator= (ResourceHandle&& right) noexcept
+	{
+		ResourceHandle{ std::move(right) }.swap(*this);
+		return *this;
+	}
+
+	inline bool operator== (const ResourceHandle& right) const { return _entry == right._entry; }
+
+public:
+	inline _Ty* get() const { return _entry ? &_entry->value : nullptr; }
+	inline _Ty& operator* () const { return _entry->value; }
+	inline _Ty* operator-> () const { return &_entry->value; }
+
+	inline operator bool() const { return _entry; }
+	inline bool operator! () const { return !_entry; }
+
+	inline Symbol key() const { return _entry ? _entry->key : Symbol{}; }
+	inline UInt32 useCount() const { return _entry ? _entry->refs : 0; }
+
+	inline void reset() { ResourceHandle{}.swap(*this); }
+	inline void swap(ResourceHandle& other) noexcept { std::swap(_entry, other._entry); }
+
+private:
+	inline explicit ResourceHandle(ResourceEntry<_Ty>* entry) : _entry{ entry } { _retain(); }
+
+	inline void _retain() { if (_entry) ++_entry->refs; }
+
+	inline void _release()
+	{
+		if (_entry && --_entry->refs == 0)
+			_entry->cache->_release(_entry);
+	}
+
+public:
+	friend class ResourceCache<_Ty>;
+};
+
+
+
+/*
+ * Loaded resources of one type keyed by their normalized path. Entries stay
+ * cached while any handle refers to them; once released they move to an LRU
+ * idle list that keeps up to idleCapacity() of them around for the next
+ * acquire, so going back and forth between scenes does not reload from disk.
+ */
+template<Loadable _Ty>
+class ResourceCache
+{
+public:
+	using value_type = _Ty;
+	using handle_type = ResourceHandle<_Ty>;
+
+	static constexpr Size default_idle_capacity = 64;
+
+private:
+	using Entry = ResourceEntry<_Ty>;
+
+	FlatHashMap<Symbol, uref<Entry>, Symbol::hash> _entries;
+	std::list<Entry*> _idle;
+	Size _idleCapacity = default_idle_capacity;
+	ResourceStats _stats;
+
+public:
+	ResourceCache() = default;
+	~ResourceCache() = default;
+
+	ResourceCache(const ResourceCache&) = delete;
+	ResourceCache(ResourceCache&&) = delete;
+
+	ResourceCache& operator= (const ResourceCache&) = delete;
+	ResourceCache& operator= (ResourceCache&&) = delete;
+
+public:
+	handle_type acquire(const ResourceFolder& folder, const Path& path)
+	{
+		Symbol key = folder.keyOf(path);
+		if (handle_type handle = find(key))
+		{
+			++_stats.hits;
+			return handle;
+		}
+
+		return emplace(key, [&folder, &path](_Ty& resource) { return ResourceLoader<_Ty>::load(folder, path, resource); });
+	}
+
+	inline handle_type acquire(const ResourceFolder& folder, const String& filename) { return acquire(folder, Path{ filename }); }
+	inline handle_type acquire(const ResourceFolder& folder, const char* filename) { return acquire(folder, Path{ filename }); }
+	inline handle_type acquire(const ResourceFolder& folder, Symbol filename) { return acquire(folder, Path{ filename.view() }); }
+
+	handle_type find(Symbol key)
+	{
+		auto it = _entries.find(key);
+		if (it == _entries.end())
+			return {};
+
+		_unidle(it->second.get());
+		return handle_type{ it->second.get() };
+	}
+
+	inline bool contains(Symbol key) const { return _entries.contains(key); }
+
+	/*
+	 * Fills the entry for key through loader. An existing entry is reloaded
+	 * into a fresh value that replaces the old one only once loading succeeded,
+	 * so its handles never see a partially loaded or failed resource.
+	 */
+	template<std::predicate<_Ty&> _Fty>
+	handle_type emplace(Symbol key, _Fty&& loader)
+	{
+		auto it = _entries.find(key);
+		if (it != _entries.end())
+		{
+			Entry* existing = it->second.get();
+			_Ty value{};
+			if (!loader(value))
+			{
+				++_stats.failures;
+				return {};
+			}
+
+			++_stats.reloads;
+			existing->value = std::move(value);
+			_unidle(existing);
+			return handle_type{ existing };
+		}
+
+		uref<Entry> entry = std::make_unique<Entry>();
+		if (!loader(entry->value))
+		{
+			++_stats.failures;
+			return {};
+		}
+
+		++_stats.misses;
+		return _emplace(key, std::move(entry));
+	}
+
+	/* Stores an already loaded value; an existing entry is replaced in place so its handles see the new value */
+	handle_type insert(Symbol key, _Ty&& value)
+	{
+		auto it = _entries.find(key);
+		if (it != _entries.end())
+		{
+			it->second->value = std::move(value);
+			_unidle(it->second.get());
+			return handle_type{ it->second.get() };
+		}
+
+		uref<Entry> entry = std::make_unique<Entry>(std::move(value));
+		return _emplace(key, std::move(entry));
+	}
+
+	void setIdleCapacity(Size capacity)
+	{
+		_idleCapacity = capacity;
+		_trim();
+	}
+
+	inline Size idleCapacity() const { return _idleCapacity; }
+
+	Size collect()
+	{
+		Size count = _idle.size();
+		while (!_idle.empty())
+			_evict(_idle.front());
+		return count;
+	}
+
+	inline Size size() const { return _entries.size(); }
+	inline Size idleCount() const { return _idle.size(); }
+
+	inline ResourceStats stats() const
+	{
+		ResourceStats stats = _stats;
+		stats.entries = _entries.size();
+		stats.idle = _idle.size();
+		return stats;
+	}
+
+	inline void resetStats() { _stats = {}; }
+
+private:
+	handle_type _emplace(Symbol key, uref<Entry> entry)
+	{
+		Entry* raw = entry.get();
+		raw->key = key;
+		raw->cache = this;
+		_entries.emplace(key, std::move(entry));
+		return handle_type{ raw };
+	}
+
+	void _unidle(Entry* entry)
+	{
+		if (entry->isIdle)
+		{
+			_idle.erase(entry->idle);
+			entry->isIdle = false;
+		}
+	}
+
+	void _release(Entry* entry)
+	{
+		entry->idle = _idle.insert(_idle.end(), entry);
+		entry->isIdle = true;
+		_trim();
+	}
+
+	void _trim()
+	{
+		while (_idle.size() > _idleCapacity)
+			_evict(_idle.front());
+	}
+
+	void _evict(Entry* entry)
+	{
+		_idle.erase(entry->idle);
+		++_stats.evictions;
+		_entries.erase(entry->key);
+	}
+
+public:
+	friend class ResourceHandle<_Ty>;
+};
+
+
+
+class ResourceManager
+{
+private:
+	ResourceFolder _root;
+	ResourceCache<sf::Texture> _textures;
+	ResourceCache<sf::Image> _images;
+	ResourceCache<sf::Font> _fonts;
+	ResourceCache<sf::SoundBuffer> _sounds;
+	ResourceCache<Json> _documents;
+
+public:
+	ResourceManager() = default;
+	explicit ResourceManager(const ResourceFolder& root);
+
+	ResourceManager(const ResourceManager&) = delete;
+	ResourceManager(ResourceManager&&) = delete;
+
+	ResourceManager& operator= (const ResourceManager&) = delete;
+	ResourceManager& operator= (ResourceManager&&) = delete;
+
+public:
+	inline const ResourceFolder& root() const { return _root; }
+	inline void setRoot(const ResourceFolder& root) { _root = root; }
+
+	template<typename _Ty>
+	ResourceCache<_Ty>& cache()
+	{
+		if constexpr (std::same_as<_Ty, sf::Texture>)
+			return _textures;
+		else if constexpr (std::same_as<_Ty, sf::Image>)
+			return _images;
+		else if constexpr (std::same_as<_Ty, sf::Font>)
+			return _fonts;
+		else if constexpr (std::same_as<_Ty, sf::SoundBuffer>)
+			return _sounds;
+		else
+		{
+			static_assert(std::same_as<_Ty, Json>, "unmanaged resource type");
+			return _documents;
+		}
+	}
+
+	template<typename _Fty>
+	void forEachCache(_Fty&& action)
+	{
+		action(_textures);
+		action(_images);
+		action(_fonts);
+		action(_sounds);
+		action(_documents);
+	}
+
+	template<typename _Ty>
+	inline ResourceHandle<_Ty> load(const Path& path) { return cache<_Ty>().acquire(_root, path); }
+
+	template<typename _Ty>
+	inline ResourceHandle<_Ty> load(Symbol filename) { return cache<_Ty>().acquire(_root, filename); }
+
+	inline ResourceHandle<sf::Texture> texture(const Path& path) { return load<sf::Texture>(path); }
+	inline ResourceHandle<sf::Image> image(const Path& path) { return load<sf::Image>(path); }
+	inline ResourceHandle<sf::Font> font(const Path& path) { return load<sf::Font>(path); }
+	inline ResourceHandle<sf::SoundBuffer> sound(const Path& path) { return load<sf::SoundBuffer>(path); }
+	inline ResourceHandle<Json> json(const Path& path) { return load<Json>(path); }
+
+	Size collect();
+	ResourceStats stats() const;
+	void resetStats();
+};
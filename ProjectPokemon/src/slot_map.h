@@ -0,0 +1,216 @@
+#pragma once
+
+#include "common.h"
+
+class SlotHandle
+{
+public:
+	static constexpr UInt32 invalid_index = ~UInt32(0);
+
+private:
+	UInt32 _index = invalid_index;
+	UInt32 _generation = 0;
+
+public:
+	constexpr SlotHandle() = default;
+	constexpr SlotHandle(const SlotHandle&) = default;
+	constexpr SlotHandle(UInt32 index, UInt32 generation) : _index{ index }, _generation{ generation } {}
+	~SlotHandle() = default;
+
+	constexpr SlotHandle& operator= (const SlotHandle&) = default;
+
+	constexpr bool operator== (const SlotHandle&) const = default;
+	constexpr auto operator<=> (const SlotHandle&) const = default;
+
+	constexpr UInt32 index() const { return _index; }
+	constexpr UInt32 generation() const { return _generation; }
+
+	constexpr CompactId compact() const { return _index < CompactId::invalid_index ? CompactId{ _index, _generation } : CompactId{}; }
+
+	constexpr operator bool() const { return _index != invalid_index; }
+	constexpr bool operator! () const { return _index == invalid_index; }
+
+	friend inline std::ostream& operator<< (std::ostream& left, const SlotHandle& right) { return left << right._index << ':' << right._generation; }
+
+public:
+	struct hash
+	{
+		inline Size operator() (const SlotHandle& handle) const
+		{
+			return std::hash<UInt64>()((static_cast<UInt64>(handle._generation) << 32) | handle._index);
+		}
+	};
+};
+
+
+
+/*
+ * Dense storage addressed by generational handles. Values are kept contiguous
+ * (erase swaps the last value into the hole) while the sparse slot table keeps
+ * handles stable. A slot is alive while its generation is odd, so a stale
+ * handle never matches a reused slot. All three arrays share one
+ * std::pmr::memory_resource.
+ */
+template<typename _Ty>
+class SlotMap
+{
+public:
+	using value_type = _Ty;
+	using iterator = typename std::pmr::vector<_Ty>::iterator;
+	using const_iterator = typename std::pmr::vector<_Ty>::const_iterator;
+
+private:
+	struct Slot
+	{
+		UInt32 index;
+		UInt32 generation;
+	};
+
+	std::pmr::vector<_Ty> _values;
+	std::pmr::vector<UInt32> _owners;
+	std::pmr::vector<Slot> _slots;
+	UInt32 _freeHead = SlotHandle::invalid_index;
+
+public:
+	SlotMap() = default;
+	explicit SlotMap(std::pmr::memory_resource* resource) : _values{ resource }, _owners{ resource }, _slots{ resource } {}
+	SlotMap(const SlotMap&) = default;
+	SlotMap(SlotMap&&) noexcept = default;
+	~SlotMap() = default;
+
+	SlotMap& operator= (const SlotMap&) = default;
+	SlotMap& operator= (SlotMap&&) noexcept = default;
+
+public:
+	inline Size size() const { return _values.size(); }
+	inline bool empty() const { return _values.empty(); }
+	inline std::pmr::memory_resource* resource() const { return _values.get_allocator().resource(); }
+	inline Size capacity() const { return _values.capacity(); }
+
+	inline _Ty* data() { return _values.data(); }
+	inline const _Ty* data() const { return _values.data(); }
+
+	void reserve(Size count)
+	{
+		_values.reserve(count);
+		_owners.reserve(count);
+		_slots.reserve(count);
+	}
+
+	void clear()
+	{
+		for (UInt32 owner : _owners)
+			_release(owner);
+		_values.clear();
+		_owners.clear();
+	}
+
+	template<typename... _Args>
+	SlotHandle emplace(_Args&&... args)
+	{
+		UInt32 slotIdx = _acquire();
+		_values.emplace_back(std::forward<_Args>(args)...);
+		_owners.push_back(slotIdx);
+
+		Slot& slot = _slots[slotIdx];
+		slot.index = static_cast<UInt32>(_values.size() - 1);
+		return { slotIdx, slot.generation };
+	}
+
+	inline SlotHandle insert(const _Ty& value) { return emplace(value); }
+	inline SlotHandle insert(_Ty&& value) { return emplace(std::move(value)); }
+
+	bool erase(SlotHandle handle)
+	{
+		if (!contains(handle))
+			return false;
+
+		UInt32 denseIdx = _slots[handle.index()].index;
+		UInt32 lastIdx = static_cast<UInt32>(_values.size() - 1);
+		if (denseIdx != lastIdx)
+		{
+			_values[denseIdx] = std::move(_values[lastIdx]);
+			_owners[denseIdx] = _owners[lastIdx];
+			_slots[_owners[denseIdx]].index = denseIdx;
+		}
+		_values.pop_back();
+		_owners.pop_back();
+		_release(handle.index());
+		return true;
+	}
+
+	inline bool contains(SlotHandle handle) const
+	{
+		return handle.index() < _slots.size() && _slots[handle.index()].generation == handle.generation();
+	}
+
+	inline bool contains(CompactId id) const
+	{
+		return id && id.index() < _slots.size() && (_slots[id.index()].generation & 1) && ((_slots[id.index()].generation & CompactId::generation_mask) == id.generation());
+	}
+
+	inline SlotHandle expand(CompactId id) const { return contains(id) ? SlotHandle{ id.index(), _slots[id.index()].generation } : SlotHandle{}; }
+
+	inline _Ty* get(CompactId id) { return get(expand(id)); }
+	inline const _Ty* get(CompactId id) const { return get(expand(id)); }
+
+	inline _Ty* get(SlotHandle handle) { return contains(handle) ? std::addressof(_values[_slots[handle.index()].index]) : nullptr; }
+	inline const _Ty* get(SlotHandle handle) const { return contains(handle) ? std::addressof(_values[_slots[handle.index()].index]) : nullptr; }
+
+	inline _Ty& operator[] (SlotHandle handle) { return _values[_slots[handle.index()].index]; }
+	inline const _Ty& operator[] (SlotHandle handle) const { return _values[_slots[handle.index()].index]; }
+
+	inline Offset denseIndexOf(SlotHandle handle) const { return _slots[handle.index()].index; }
+
+	void swapDense(Offset left, Offset right)
+	{
+		if (left == right)
+			return;
+
+		std::swap(_values[left], _values[right]);
+		std::swap(_owners[left], _owners[right]);
+		_slots[_owners[left]].index = static_cast<UInt32>(left);
+		_slots[_owners[right]].index = static_cast<UInt32>(right);
+	}
+
+	inline SlotHandle handleAt(Offset denseIdx) const
+	{
+		UInt32 slotIdx = _owners[denseIdx];
+		return { slotIdx, _slots[slotIdx].generation };
+	}
+
+	inline _Ty& at(Offset denseIdx) { return _values[denseIdx]; }
+	inline const _Ty& at(Offset denseIdx) const { return _values[denseIdx]; }
+
+	inline iterator begin() { return _values.begin(); }
+	inline const_iterator begin() const { return _values.begin(); }
+	inline const_iterator cbegin() const { return _values.cbegin(); }
+
+	inline iterator end() { return _values.end(); }
+	inline const_iterator end() const { return _values.end(); }
+	inline const_iterator cend() const { return _values.cend(); }
+
+private:
+	UInt32 _acquire()
+	{
+		if (_freeHead != SlotHandle::invalid_index)
+		{
+			UInt32 slotIdx = _freeHead;
+			Slot& slot = _slots[slotIdx];
+			_freeHead = slot.index;
+			++slot.generation;
+			return slotIdx;
+		}
+
+		_slots.push_back({ SlotHandle::invalid_index, 1 });
+		return static_cast<UInt32>(_slots.size() - 1);
+	}
+
+	void _release(UInt32 slotIdx)
+	{
+		Slot& slot = _slots[slotIdx];
+		++slot.generation;
+		slot.index = _freeHead;
+		_freeHead = slotIdx;
+	}
+};
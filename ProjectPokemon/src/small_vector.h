@@ -0,0 +1,281 @@
+#pragma once
+
+#include "common.h"
+
+/*
+ * Vector that keeps up to _Inline elements inside the object itself. Only
+ * lists that outgrow it touch the heap, which is then taken from the given
+ * std::pmr::memory_resource. Copies use the default resource, like the
+ * std::pmr containers.
+ */
+template<typename _Ty, Size _Inline>
+class SmallVector
+{
+	static_assert(_Inline > 0, "SmallVector needs at least one inline element");
+
+public:
+	using value_type = _Ty;
+	using size_type = Size;
+	using difference_type = std::ptrdiff_t;
+	using reference = _Ty&;
+	using const_reference = const _Ty&;
+	using pointer = _Ty*;
+	using const_pointer = const _Ty*;
+	using iterator = _Ty*;
+	using const_iterator = const _Ty*;
+
+	static constexpr Size inline_capacity = _Inline;
+
+private:
+	_Ty* _data = _inlineData();
+	Size _size = 0;
+	Size _capacity = _Inline;
+	std::pmr::memory_resource* _resource = std::pmr::get_default_resource();
+	alignas(_Ty) std::byte _inline[_Inline * sizeof(_Ty)];
+
+public:
+	SmallVector() = default;
+
+	explicit SmallVector(std::pmr::memory_resource* resource) : _resource{ resource } {}
+
+	SmallVector(std::initializer_list<_Ty> values, std::pmr::memory_resource* resource = std::pmr::get_default_resource()) : _resource{ resource }
+	{
+		assign(values.begin(), values.end());
+	}
+
+	SmallVector(Size count, const _Ty& value, std::pmr::memory_resource* resource = std::pmr::get_default_resource()) : _resource{ resource }
+	{
+		resize(count, value);
+	}
+
+	SmallVector(const SmallVector& other, std::pmr::memory_resource* resource = std::pmr::get_default_resource()) : _resource{ resource }
+	{
+		assign(other.begin(), other.end());
+	}
+
+	SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<_Ty>) : _resource{ other._resource }
+	{
+		_take(std::move(other));
+	}
+
+	~SmallVector()
+	{
+		clear();
+		_freeHeap();
+	}
+
+	SmallVector& operator= (const SmallVector& right)
+	{
+		if (this != &right)
+			assign(right.begin(), right.end());
+		return *this;
+	}
+
+	SmallVector& operator= (SmallVector&& right) noexcept(std::is_nothrow_move_constructible_v<_Ty>)
+	{
+		if (this == &right)
+			return *this;
+
+		clear();
+		if (!right.isInline() && right._resource != _resource)
+		{
+			reserve(right._size);
+			std::uninitialized_move(right.begin(), right.end(), _data);
+			_size = right._size;
+			right.clear();
+		}
+		else
+		{
+			_freeHeap();
+			_take(std::move(right));
+		}
+		return *this;
+	}
+
+	SmallVector& operator= (std::initializer_list<_Ty> values)
+	{
+		assign(values.begin(), values.end());
+		return *this;
+	}
+
+	bool operator== (const SmallVector& right) const { return std::equal(begin(), end(), right.begin(), right.end()); }
+
+	template<typename _ValueTy>
+	friend Size erase(SmallVector& vec, const _ValueTy& value)
+	{
+		iterator it = std::remove(vec.begin(), vec.end(), value);
+		Size count = vec.end() - it;
+		vec.erase(it, vec.end());
+		return count;
+	}
+
+	template<typename _PredTy>
+	friend Size erase_if(SmallVector& vec, _PredTy pred)
+	{
+		iterator it = std::remove_if(vec.begin(), vec.end(), pred);
+		Size count = vec.end() - it;
+		vec.erase(it, vec.end());
+		return count;
+	}
+
+public:
+	inline Size size() const { return _size; }
+	inline bool empty() const { return _size == 0; }
+	inline Size capacity() const { return _capacity; }
+	inline bool isInline() const { return _data == _inlineData(); }
+	inline std::pmr::memory_resource* resource() const { return _resource; }
+
+	inline _Ty* data() { return _data; }
+	inline const _Ty* data() const { return _data; }
+
+	inline _Ty& operator[] (Size index) { return _data[index]; }
+	inline const _Ty& operator[] (Size index) const { return _data[index]; }
+
+	inline _Ty& front() { return _data[0]; }
+	inline const _Ty& front() const { return _data[0]; }
+	inline _Ty& back() { return _data[_size - 1]; }
+	inline const _Ty& back() const { return _data[_size - 1]; }
+
+	inline iterator begin() { return _data; }
+	inline const_iterator begin() const { return _data; }
+	inline const_iterator cbegin() const { return _data; }
+
+	inline iterator end() { return _data + _size; }
+	inline const_iterator end() const { return _data + _size; }
+	inline const_iterator cend() const { return _data + _size; }
+
+	void reserve(Size count)
+	{
+		if (count > _capacity)
+			_relocate(_allocate(count), count);
+	}
+
+	void shrink_to_fit()
+	{
+		if (isInline() || _size == _capacity)
+			return;
+
+		if (_size <= _Inline)
+			_relocate(_inlineData(), _Inline);
+		else _relocate(_allocate(_size), _size);
+	}
+
+	template<typename... _Args>
+	_Ty& emplace_back(_Args&&... args)
+	{
+		if (_size < _capacity)
+			return *new (_data + _size++) _Ty(std::forward<_Args>(args)...);
+
+		// Build the new element before relocating so arguments may alias the current elements
+		Size capacity = _grownCapacity(_size + 1);
+		_Ty* data = _allocate(capacity);
+		new (data + _size) _Ty(std::forward<_Args>(args)...);
+		_relocate(data, capacity);
+		return _data[_size++];
+	}
+
+	inline void push_back(const _Ty& value) { emplace_back(value); }
+	inline void push_back(_Ty&& value) { emplace_back(std::move(value)); }
+
+	inline void pop_back() { utils::destroy(_data[--_size]); }
+
+	template<typename... _Args>
+	iterator emplace(const_iterator pos, _Args&&... args)
+	{
+		Offset index = pos - begin();
+		emplace_back(std::forward<_Args>(args)...);
+		std::rotate(begin() + index, end() - 1, end());
+		return begin() + index;
+	}
+
+	inline iterator insert(const_iterator pos, const _Ty& value) { return emplace(pos, value); }
+	inline iterator insert(const_iterator pos, _Ty&& value) { return emplace(pos, std::move(value)); }
+
+	iterator erase(const_iterator first, const_iterator last)
+	{
+		iterator dst = begin() + (first - begin());
+		iterator tail = std::move(begin() + (last - begin()), end(), dst);
+		for (iterator it = tail; it != end(); ++it)
+			utils::destroy(*it);
+		_size = tail - begin();
+		return dst;
+	}
+
+	inline iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+
+	template<std::input_iterator _ItTy>
+	void assign(_ItTy first, _ItTy last)
+	{
+		clear();
+		if constexpr (std::forward_iterator<_ItTy>)
+			reserve(static_cast<Size>(std::distance(first, last)));
+		for (; first != last; ++first)
+			emplace_back(*first);
+	}
+
+	void resize(Size count)
+	{
+		reserve(count);
+		while (_size < count)
+			new (_data + _size++) _Ty();
+		while (_size > count)
+			pop_back();
+	}
+
+	void resize(Size count, const _Ty& value)
+	{
+		reserve(count);
+		while (_size < count)
+			new (_data + _size++) _Ty(value);
+		while (_size > count)
+			pop_back();
+	}
+
+	void clear()
+	{
+		std::destroy(begin(), end());
+		_size = 0;
+	}
+
+private:
+	inline _Ty* _inlineData() { return reinterpret_cast<_Ty*>(_inline); }
+	inline const _Ty* _inlineData() const { return reinterpret_cast<const _Ty*>(_inline); }
+
+	inline Size _grownCapacity(Size needed) const { return std::max(needed, _capacity * 2); }
+
+	inline _Ty* _allocate(Size capacity) { return static_cast<_Ty*>(_resource->allocate(capacity * sizeof(_Ty), alignof(_Ty))); }
+
+	void _relocate(_Ty* data, Size capacity)
+	{
+		std::uninitialized_move(begin(), end(), data);
+		std::destroy(begin(), end());
+		_freeHeap();
+		_data = data;
+		_capacity = capacity;
+	}
+
+	void _freeHeap()
+	{
+		if (!isInline())
+			_resource->deallocate(_data, _capacity * sizeof(_Ty), alignof(_Ty));
+		_data = _inlineData();
+		_capacity = _Inline;
+	}
+
+	void _take(SmallVector&& other)
+	{
+		if (other.isInline())
+		{
+			std::uninitialized_move(other.begin(), other.end(), _data);
+			_size = other._size;
+			other.clear();
+		}
+		else
+		{
+			_data = std::exchange(other._data, other._inlineData());
+			_size = std::exchange(other._size, 0);
+			_capacity = std::exchange(other._capacity, _Inline);
+			_resource = other._resource;
+		}
+	}
+};
@@ -0,0 +1,236 @@
+#include "spatial.h"
+
+SpatialGrid::SpatialGrid(float cellSize) :
+	_cellSize{ cellSize }
+{}
+
+bool SpatialGrid::insert(UniqueId uid, const sf::FloatRect& bounds)
+{
+	if (!uid || _ids.contains(uid))
+		return false;
+
+	SlotHandle handle = _entries.insert({ uid, bounds, _cellOf(bounds), 0, _isOversized(bounds) });
+	_ids.emplace(uid, handle);
+	_link(handle);
+	return true;
+}
+
+void SpatialGrid::update(UniqueId uid, const sf::FloatRect& bounds)
+{
+	auto it = _ids.find(uid);
+	if (it == _ids.end())
+	{
+		insert(uid, bounds);
+		return;
+	}
+
+	Entry& entry = _entries[it->second];
+	if (entry.bounds == bounds)
+		return;
+
+	UInt64 cell = _cellOf(bounds);
+	bool oversized = _isOversized(bounds);
+	entry.bounds = bounds;
+	if (cell != entry.cell || oversized != entry.oversized)
+	{
+		_unlink(it->second);
+		entry.cell = cell;
+		entry.oversized = oversized;
+		_link(it->second);
+	}
+	else if (!oversized)
+		_maxHalfExtent = std::max({ _maxHalfExtent, bounds.width / 2, bounds.height / 2 });
+}
+
+bool SpatialGrid::remove(UniqueId uid)
+{
+	auto it = _ids.find(uid);
+	if (it == _ids.end())
+		return false;
+
+	_unlink(it->second);
+	_entries.erase(it->second);
+	_ids.erase(it);
+	return true;
+}
+
+void SpatialGrid::clear()
+{
+	_entries.clear();
+	_ids.clear();
+	_cells.clear();
+	_oversized.clear();
+	_maxHalfExtent = 0;
+	_minCell = { std::numeric_limits<Int32>::max(), std::numeric_limits<Int32>::max() };
+	_maxCell = { std::numeric_limits<Int32>::min(), std::numeric_limits<Int32>::min() };
+}
+
+const sf::FloatRect* SpatialGrid::boundsOf(UniqueId uid) const
+{
+	auto it = _ids.find(uid);
+	return it == _ids.end() ? nullptr : &_entries[it->second].bounds;
+}
+
+std::vector<UniqueId> SpatialGrid::query(const sf::FloatRect& area) const
+{
+	std::vector<UniqueId> result;
+	query(area, [&result](UniqueId uid) { result.push_back(uid); });
+	return result;
+}
+
+std::vector<UniqueId> SpatialGrid::queryRadius(const Vec2f& center, float radius) const
+{
+	std::vector<UniqueId> result;
+	queryRadius(center, radius, [&result](UniqueId uid) { result.push_back(uid); });
+	return result;
+}
+
+std::vector<UniqueId> SpatialGrid::nearest(const Vec2f& point, Size count, float maxDistance) const
+{
+	std::vector<std::pair<float, UniqueId>> best;
+	if (count == 0 || _entries.empty())
+		return {};
+
+	float maxDistanceSq = maxDistance * maxDistance;
+	auto consider = [&best, count, maxDistanceSq, &point](const Entry& entry) {
+		float distance = distanceSquared(point, entry.bounds);
+		if (distance > maxDistanceSq)
+			return;
+
+		if (best.size() < count)
+		{
+			best.emplace_back(distance, entry.uid);
+			std::push_heap(best.begin(), best.end());
+		}
+		else if (distance < best.front().first)
+		{
+			std::pop_heap(best.begin(), best.end());
+			best.back() = { distance, entry.uid };
+			std::push_heap(best.begin(), best.end());
+		}
+	};
+
+	for (SlotHandle handle : _oversized)
+		consider(_entries[handle]);
+
+	if (_minCell.x > _maxCell.x)
+		return _sortedIds(best);
+
+	Vec2i center = _cellCoordsOf(point);
+	Int32 maxRing = std::max({
+		std::abs(center.x - _minCell.x), std::abs(_maxCell.x - center.x),
+		std::abs(center.y - _minCell.y), std::abs(_maxCell.y - center.y)
+	});
+
+	auto visit = [this, &consider](Int32 x, Int32 y) {
+		auto cell = _cells.find(_key(x, y));
+		if (cell != _cells.end())
+			for (SlotHandle handle : cell->second)
+				consider(_entries[handle]);
+	};
+
+	for (Int32 ring = 0; ring <= maxRing; ++ring)
+	{
+		float reach = (ring - 1) * _cellSize - _maxHalfExtent;
+		if (reach > 0 && (reach > maxDistance || (best.size() == count && reach * reach >= best.front().first)))
+			break;
+
+		if (ring == 0)
+		{
+			visit(center.x, center.y);
+			continue;
+		}
+
+		for (Int32 x = center.x - ring; x <= center.x + ring; ++x)
+		{
+			visit(x, center.y - ring);
+			visit(x, center.y + ring);
+		}
+		for (Int32 y = center.y - ring + 1; y <= center.y + ring - 1; ++y)
+		{
+			visit(center.x - ring, y);
+			visit(center.x + ring, y);
+		}
+	}
+
+	return _sortedIds(best);
+}
+
+std::vector<UniqueId> SpatialGrid::_sortedIds(std::vector<std::pair<float, UniqueId>>& heap)
+{
+	std::sort_heap(heap.begin(), heap.end());
+
+	std::vector<UniqueId> result;
+	result.reserve(heap.size());
+	for (const auto& entry : heap)
+		result.push_back(entry.second);
+	return result;
+}
+
+sf::FloatRect SpatialGrid::viewBounds(const sf::View& view)
+{
+	const Vec2f& center = view.getCenter();
+	const Vec2f& size = view.getSize();
+	float radians = view.getRotation() * 3.14159265f / 180.f;
+	float cos = std::abs(std::cos(radians));
+	float sin = std::abs(std::sin(radians));
+
+	Vec2f extent{ (size.x * cos + size.y * sin) / 2, (size.x * sin + size.y * cos) / 2 };
+	return { center.x - extent.x, center.y - extent.y, extent.x * 2, extent.y * 2 };
+}
+
+float SpatialGrid::distanceSquared(const Vec2f& point, const sf::FloatRect& bounds)
+{
+	float dx = std::max({ bounds.left - point.x, 0.f, point.x - (bounds.left + bounds.width) });
+	float dy = std::max({ bounds.top - point.y, 0.f, point.y - (bounds.top + bounds.height) });
+	return dx * dx + dy * dy;
+}
+
+Vec2i SpatialGrid::_cellCoordsOf(const Vec2f& point) const
+{
+	return {
+		static_cast<Int32>(std::floor(point.x / _cellSize)),
+		static_cast<Int32>(std::floor(point.y / _cellSize))
+	};
+}
+
+bool SpatialGrid::_isOversized(const sf::FloatRect& bounds) const
+{
+	return bounds.width > _cellSize * 2 || bounds.height > _cellSize * 2;
+}
+
+UInt64 SpatialGrid::_cellOf(const sf::FloatRect& bounds) const
+{
+	Vec2i coords = _cellCoordsOf({ bounds.left + bounds.width / 2, bounds.top + bounds.height / 2 });
+	return _key(coords.x, coords.y);
+}
+
+void SpatialGrid::_link(SlotHandle handle)
+{
+	Entry& entry = _entries[handle];
+	CellList& list = entry.oversized ? _oversized : _cells[entry.cell];
+	entry.slot = static_cast<UInt32>(list.size());
+	list.push_back(handle);
+
+	if (entry.oversized)
+		return;
+
+	_maxHalfExtent = std::max({ _maxHalfExtent, entry.bounds.width / 2, entry.bounds.height / 2 });
+
+	Vec2i coords{ static_cast<Int32>(entry.cell >> 32), static_cast<Int32>(entry.cell & 0xFFFFFFFF) };
+	_minCell.x = std::min(_minCell.x, coords.x), _minCell.y = std::min(_minCell.y, coords.y);
+	_maxCell.x = std::max(_maxCell.x, coords.x), _maxCell.y = std::max(_maxCell.y, coords.y);
+}
+
+void SpatialGrid::_unlink(SlotHandle handle)
+{
+	Entry& entry = _entries[handle];
+	CellList& list = entry.oversized ? _oversized : _cells[entry.cell];
+	SlotHandle last = list.back();
+	list[entry.slot] = last;
+	_entries[last].slot = entry.slot;
+	list.pop_back();
+
+	if (list.empty() && !entry.oversized)
+		_cells.erase(entry.cell);
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "common.h"
+#include "slot_map.h"
+#include "small_vector.h"
+
+/*
+ * Loose uniform grid. Each entry lives in the cell containing its center and
+ * queries widen their search by the largest half extent seen so far; entries
+ * larger than a cell are kept aside in an oversized list so they never blow up
+ * the search window.
+ */
+class SpatialGrid
+{
+private:
+	typedef SmallVector<SlotHandle, 4> CellList;
+
+	struct Entry
+	{
+		UniqueId uid;
+		sf::FloatRect bounds;
+		UInt64 cell;
+		UInt32 slot;
+		bool oversized;
+	};
+
+	float _cellSize;
+	float _maxHalfExtent = 0;
+	SlotMap<Entry> _entries;
+	FlatHashMap<UniqueId, SlotHandle, UniqueId::hash> _ids;
+	std::unordered_map<UInt64, CellList> _cells;
+	CellList _oversized;
+	Vec2i _minCell = { std::numeric_limits<Int32>::max(), std::numeric_limits<Int32>::max() };
+	Vec2i _maxCell = { std::numeric_limits<Int32>::min(), std::numeric_limits<Int32>::min() };
+
+public:
+	explicit SpatialGrid(float cellSize = 128.f);
+	SpatialGrid(const SpatialGrid&) = default;
+	SpatialGrid(SpatialGrid&&) noexcept = default;
+	~SpatialGrid() = default;
+
+	SpatialGrid& operator= (const SpatialGrid&) = default;
+	SpatialGrid& operator= (SpatialGrid&&) noexcept = default;
+
+public:
+	inline float cellSize() const { return _cellSize; }
+	inline Size size() const { return _entries.size(); }
+	inline bool empty() const { return _entries.empty(); }
+	inline bool contains(UniqueId uid) const { return _ids.contains(uid); }
+
+	bool insert(UniqueId uid, const sf::FloatRect& bounds);
+	void update(UniqueId uid, const sf::FloatRect& bounds);
+	bool remove(UniqueId uid);
+	void clear();
+
+	const sf::FloatRect* boundsOf(UniqueId uid) const;
+
+	template<typename _Fty>
+	void query(const sf::FloatRect& area, _Fty&& action) const
+	{
+		_forEachCandidate(area, [&area, &action](const Entry& entry) {
+			if (entry.bounds.intersects(area))
+				action(entry.uid);
+		});
+	}
+
+	template<typename _Fty>
+	void queryRadius(const Vec2f& center, float radius, _Fty&& action) const
+	{
+		sf::FloatRect area{ center.x - radius, center.y - radius, radius * 2, radius * 2 };
+		float radiusSq = radius * radius;
+		_forEachCandidate(area, [&center, radiusSq, &action](const Entry& entry) {
+			if (distanceSquared(center, entry.bounds) <= radiusSq)
+				action(entry.uid);
+		});
+	}
+
+	std::vector<UniqueId> query(const sf::FloatRect& area) const;
+	std::vector<UniqueId> queryRadius(const Vec2f& center, float radius) const;
+	std::vector<UniqueId> nearest(const Vec2f& point, Size count, float maxDistance = std::numeric_limits<float>::infinity()) const;
+
+	static sf::FloatRect viewBounds(const sf::View& view);
+	static float distanceSquared(const Vec2f& point, const sf::FloatRect& bounds);
+
+private:
+	Vec2i _cellCoordsOf(const Vec2f& point) const;
+	UInt64 _cellOf(const sf::FloatRect& bounds) const;
+	bool _isOversized(const sf::FloatRect& bounds) const;
+	void _link(SlotHandle handle);
+	void _unlink(SlotHandle handle);
+
+	static std::vector<UniqueId> _sortedIds(std::vector<std::pair<float, UniqueId>>& heap);
+
+	static inline UInt64 _key(Int32 x, Int32 y) { return (static_cast<UInt64>(static_cast<UInt32>(x)) << 32) | static_cast<UInt32>(y); }
+
+	template<typename _Fty>
+	void _forEachCandidate(const sf::FloatRect& area, _Fty&& action) const
+	{
+		if (_entries.empty())
+			return;
+
+		for (SlotHandle handle : _oversized)
+			action(_entries[handle]);
+
+		Vec2i from = _cellCoordsOf({ area.left - _maxHalfExtent, area.top - _maxHalfExtent });
+		Vec2i to = _cellCoordsOf({ area.left + area.width + _maxHalfExtent, area.top + area.height + _maxHalfExtent });
+		from.x = std::max(from.x, _minCell.x), from.y = std::max(from.y, _minCell.y);
+		to.x = std::min(to.x, _maxCell.x), to.y = std::min(to.y, _maxCell.y);
+
+		for (Int32 y = from.y; y <= to.y; ++y)
+		{
+			for (Int32 x = from.x; x <= to.x; ++x)
+			{
+				auto cell = _cells.find(_key(x, y));
+				if (cell != _cells.end())
+					for (SlotHandle handle : cell->second)
+						action(_entries[handle]);
+			}
+		}
+	}
+};
@@ -0,0 +1,122 @@
+#include "symbol.h"
+#include "arena.h"
+
+namespace
+{
+	constexpr Size symbol_shard_bits = 4;
+	constexpr Size symbol_shard_count = Size(1) << symbol_shard_bits;
+	constexpr Size symbol_chunk_size = 16 * 1024;
+
+	struct SymbolShard
+	{
+		std::shared_mutex mutex;
+		FlatHashMap<std::string_view, const Symbol::Entry*> entries;
+		LinearArena storage{ symbol_chunk_size };
+		Size bytes = 0;
+	};
+
+	/* Intentionally leaked so symbols stay valid during static destruction */
+	SymbolShard* symbol_shards()
+	{
+		static SymbolShard* const shards = new SymbolShard[symbol_shard_count];
+		return shards;
+	}
+
+	inline SymbolShard& shard_of(Size hash)
+	{
+		return symbol_shards()[utils::mix_bits(hash) >> (64 - symbol_shard_bits)];
+	}
+}
+
+Symbol::Symbol(std::string_view text)
+{
+	if (text.empty())
+		return;
+
+	Size hash = std::hash<std::string_view>()(text);
+	SymbolShard& shard = shard_of(hash);
+	{
+		std::shared_lock lock{ shard.mutex };
+		auto it = shard.entries.find(text);
+		if (it != shard.entries.end())
+		{
+			_entry = it->second;
+			return;
+		}
+	}
+
+	std::unique_lock lock{ shard.mutex };
+	auto it = shard.entries.find(text);
+	if (it != shard.entries.end())
+	{
+		_entry = it->second;
+		return;
+	}
+
+	char* chars = static_cast<char*>(shard.storage.allocate(text.size() + 1, 1));
+	std::memcpy(chars, text.data(), text.size());
+	chars[text.size()] = '\0';
+
+	Entry* entry = static_cast<Entry*>(shard.storage.allocate(sizeof(Entry), alignof(Entry)));
+	_entry = new (entry) Entry{ hash, { chars, text.size() } };
+	shard.entries.emplace(_entry->text, _entry);
+	shard.bytes += text.size() + 1 + sizeof(Entry);
+}
+
+Symbol Symbol::find(std::string_view text)
+{
+	Symbol symbol;
+	if (text.empty())
+		return symbol;
+
+	SymbolShard& shard = shard_of(std::hash<std::string_view>()(text));
+	std::shared_lock lock{ shard.mutex };
+	auto it = shard.entries.find(text);
+	if (it != shard.entries.end())
+		symbol._entry = it->second;
+	return symbol;
+}
+
+Size Symbol::internedCount()
+{
+	Size count = 0;
+	SymbolShard* shards = symbol_shards();
+	for (Size i = 0; i < symbol_shard_count; ++i)
+	{
+		std::shared_lock lock{ shards[i].mutex };
+		count += shards[i].entries.size();
+	}
+	return count;
+}
+
+Size Symbol::internedBytes()
+{
+	Size bytes = 0;
+	SymbolShard* shards = symbol_shards();
+	for (Size i = 0; i < symbol_shard_count; ++i)
+	{
+		std::shared_lock lock{ shards[i].mutex };
+		bytes += shards[i].bytes;
+	}
+	return bytes;
+}
+
+Json& operator<< (Json& left, const Symbol& right)
+{
+	return left = right.view(), left;
+}
+
+Json& operator>> (Json& left, Symbol& right)
+{
+	return right = Symbol{ left.get_ref<const String&>() }, left;
+}
+
+void to_json(Json& json, const Symbol& symbol)
+{
+	json = symbol.view();
+}
+
+void from_json(const Json& json, Symbol& symbol)
+{
+	symbol = Symbol{ json.get_ref<const String&>() };
+}
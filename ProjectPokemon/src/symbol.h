@@ -0,0 +1,68 @@
+#pragma once
+
+#include "common.h"
+
+/*
+ * Interned string. Every distinct text is stored once in a global table and a
+ * Symbol is just a pointer to that entry, so copies, equality and hashing are
+ * O(1). Ordering still compares the text, keeping sorted containers stable
+ * between runs. The empty Symbol has no entry and interning "" yields it.
+ */
+class Symbol
+{
+public:
+	struct Entry
+	{
+		Size hash;
+		std::string_view text;
+	};
+
+private:
+	const Entry* _entry = nullptr;
+
+public:
+	constexpr Symbol() = default;
+	constexpr Symbol(const Symbol&) = default;
+	explicit Symbol(std::string_view text);
+	explicit Symbol(const char* text) : Symbol{ std::string_view{ text } } {}
+	explicit Symbol(const String& text) : Symbol{ std::string_view{ text } } {}
+	~Symbol() = default;
+
+	constexpr Symbol& operator= (const Symbol&) = default;
+
+	constexpr bool operator== (const Symbol&) const = default;
+	inline std::strong_ordering operator<=> (const Symbol& right) const { return _entry == right._entry ? std::strong_ordering::equal : view() <=> right.view(); }
+
+	inline bool operator== (std::string_view right) const { return view() == right; }
+
+	inline std::string_view view() const { return _entry ? _entry->text : std::string_view{}; }
+	inline const char* c_str() const { return _entry ? _entry->text.data() : ""; }
+	inline String str() const { return String{ view() }; }
+
+	inline Size size() const { return _entry ? _entry->text.size() : 0; }
+	inline bool empty() const { return !_entry; }
+
+	inline operator bool() const { return _entry; }
+	inline bool operator! () const { return !_entry; }
+
+	static Symbol find(std::string_view text);
+
+	static Size internedCount();
+	static Size internedBytes();
+
+	friend inline std::ostream& operator<< (std::ostream& left, const Symbol& right) { return left << right.view(); }
+
+	friend Json& operator<< (Json& left, const Symbol& right);
+	friend Json& operator>> (Json& left, Symbol& right);
+
+	friend void to_json(Json& json, const Symbol& symbol);
+	friend void from_json(const Json& json, Symbol& symbol);
+
+public:
+	struct hash
+	{
+		inline Size operator() (const Symbol& symbol) const { return symbol._entry ? symbol._entry->hash : 0; }
+	};
+};
+
+inline Symbol operator"" _sym(const char* str, Size size) { return Symbol{ std::string_view{ str, size } }; }
@@ -0,0 +1,169 @@
+#include "vfs.h"
+
+MountId VirtualFileSystem::mount(const ResourceFolder& folder, Int32 priority)
+{
+	std::unique_lock lock{ _mutex };
+	MountId id = _nextId++;
+
+	/* Ahead of every mount with the same or a lower priority */
+	auto it = std::ranges::find_if(_mounts, [priority](const Mount& mount) { return mount.info.priority <= priority; });
+	_mounts.insert(it, Mount{ { id, priority, std::make_shared<const ResourceFolder>(folder) }, {} });
+	_invalidate();
+	return id;
+}
+
+MountId VirtualFileSystem::mount(const Path& directory, Int32 priority)
+{
+	return mount(ResourceFolder{ directory }, priority);
+}
+
+MountId VirtualFileSystem::mountArchive(const Path& file, Int32 priority)
+{
+	auto archive = std::make_shared<Archive>();
+	if (!archive->open(file))
+		return 0;
+
+	return mount(ResourceFolder{ ref<const Archive>{ std::move(archive) } }, priority);
+}
+
+bool VirtualFileSystem::unmount(MountId id)
+{
+	std::unique_lock lock{ _mutex };
+	auto it = std::ranges::find_if(_mounts, [id](const Mount& mount) { return mount.info.id == id; });
+	if (it == _mounts.end())
+		return false;
+
+	_mounts.erase(it);
+	_invalidate();
+	return true;
+}
+
+void VirtualFileSystem::clear()
+{
+	std::unique_lock lock{ _mutex };
+	_mounts.clear();
+	_invalidate();
+}
+
+std::vector<VirtualFileSystem::MountInfo> VirtualFileSystem::mounts() const
+{
+	std::shared_lock lock{ _mutex };
+	std::vector<MountInfo> infos;
+	infos.reserve(_mounts.size());
+	for (const Mount& mount : _mounts)
+		infos.push_back(mount.info);
+	return infos;
+}
+
+Size VirtualFileSystem::mountCount() const
+{
+	std::shared_lock lock{ _mutex };
+	return _mounts.size();
+}
+
+VirtualFileSystem::Resolved VirtualFileSystem::resolve(const Path& path) const
+{
+	String name = normalize(path);
+	if (name.empty() || name == ".." || name.starts_with("../"))
+		return {};
+
+	Symbol key{ name };
+	{
+		std::shared_lock lock{ _mutex };
+		auto it = _resolved.find(key);
+		if (it != _resolved.end())
+			return it->second == unresolved ? Resolved{} : Resolved{ _mounts[it->second].info.folder, Path{ name } };
+	}
+
+	std::unique_lock lock{ _mutex };
+	Size slash = name.rfind('/');
+	Symbol directory = slash == String::npos ? Symbol{} : Symbol{ std::string_view{ name }.substr(0, slash) };
+	std::string_view leaf = slash == String::npos ? std::string_view{ name } : std::string_view{ name }.substr(slash + 1);
+
+	Int32 index = unresolved;
+	for (Size i = 0; i < _mounts.size() && index == unresolved; ++i)
+		if (std::ranges::binary_search(_listingOf(_mounts[i], directory), leaf, std::less<>{}))
+			index = static_cast<Int32>(i);
+
+	_resolved.emplace(key, index);
+	return index == unresolved ? Resolved{} : Resolved{ _mounts[index].info.folder, Path{ name } };
+}
+
+ref<const VirtualFileSystem::Listing> VirtualFileSystem::list(const Path& directory) const
+{
+	String name = normalize(directory);
+	if (name == ".." || name.starts_with("../"))
+		return std::make_shared<const Listing>();
+
+	Symbol key{ name };
+	{
+		std::shared_lock lock{ _mutex };
+		auto it = _merged.find(key);
+		if (it != _merged.end())
+			return it->second;
+	}
+
+	std::unique_lock lock{ _mutex };
+	Listing merged;
+	for (const Mount& mount : _mounts)
+	{
+		const Listing& listing = _listingOf(mount, key);
+		merged.insert(merged.end(), listing.begin(), listing.end());
+	}
+	std::ranges::sort(merged);
+	merged.erase(std::ranges::unique(merged).begin(), merged.end());
+
+	ref<const Listing> result = std::make_shared<const Listing>(std::move(merged));
+	_merged.insert_or_assign(key, result);
+	return result;
+}
+
+ref<const ResourceFolder> VirtualFileSystem::writeTarget() const
+{
+	std::shared_lock lock{ _mutex };
+	for (const Mount& mount : _mounts)
+		if (!mount.info.folder->isPacked())
+			return mount.info.folder;
+	return nullptr;
+}
+
+void VirtualFileSystem::invalidate() const
+{
+	std::unique_lock lock{ _mutex };
+	_invalidate();
+}
+
+Size VirtualFileSystem::cachedPaths() const
+{
+	std::shared_lock lock{ _mutex };
+	return _resolved.size();
+}
+
+String VirtualFileSystem::normalize(const Path& path)
+{
+	String name = path.lexically_normal().generic_string();
+	if (name == ".")
+		return {};
+
+	Size begin = name.find_first_not_of('/');
+	Size end = name.find_last_not_of('/');
+	return begin == String::npos ? String{} : name.substr(begin, end - begin + 1);
+}
+
+void VirtualFileSystem::_invalidate() const
+{
+	_resolved.clear();
+	_merged.clear();
+	for (const Mount& mount : _mounts)
+		mount.listings.clear();
+}
+
+const VirtualFileSystem::Listing& VirtualFileSystem::_listingOf(const Mount& mount, Symbol directory) const
+{
+	auto it = mount.listings.find(directory);
+	if (it != mount.listings.end())
+		return *it->second;
+
+	auto listing = std::make_shared<const Listing>(mount.info.folder->list(Path{ directory.view() }));
+	return *mount.listings.insert_or_assign(directory, std::move(listing)).first->second;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "common.h"
+#include "resource.h"
+
+typedef UInt32 MountId;
+
+/*
+ * Overlays several ResourceFolders (base game, DLC, mods, archives) into one
+ * tree. A path resolves to the highest priority mount that holds it, and for
+ * equal priorities the most recent mount wins. Each mount directory is listed
+ * once and kept, so resolving goes through hash lookups instead of the OS;
+ * resolved paths are cached as well. Changing the mounts drops every cache,
+ * files changed behind its back need an explicit invalidate().
+ */
+class VirtualFileSystem
+{
+public:
+	typedef std::vector<String> Listing;
+
+	struct Resolved
+	{
+		ref<const ResourceFolder> folder;
+		Path path;
+
+		inline explicit operator bool() const { return static_cast<bool>(folder); }
+		inline bool operator! () const { return !folder; }
+	};
+
+	struct MountInfo
+	{
+		MountId id;
+		Int32 priority;
+		ref<const ResourceFolder> folder;
+	};
+
+private:
+	struct Mount
+	{
+		MountInfo info;
+		mutable FlatHashMap<Symbol, ref<const Listing>, Symbol::hash> listings;
+	};
+
+	static constexpr Int32 unresolved = -1;
+
+	std::vector<Mount> _mounts;
+	MountId _nextId = 1;
+	mutable std::shared_mutex _mutex;
+	mutable FlatHashMap<Symbol, Int32, Symbol::hash> _resolved;
+	mutable FlatHashMap<Symbol, ref<const Listing>, Symbol::hash> _merged;
+
+public:
+	VirtualFileSystem() = default;
+	~VirtualFileSystem() = default;
+
+	VirtualFileSystem(const VirtualFileSystem&) = delete;
+	VirtualFileSystem(VirtualFileSystem&&) = delete;
+
+	VirtualFileSystem& operator= (const VirtualFileSystem&) = delete;
+	VirtualFileSystem& operator= (VirtualFileSystem&&) = delete;
+
+public:
+	MountId mount(const ResourceFolder& folder, Int32 priority = 0);
+	MountId mount(const Path& directory, Int32 priority = 0);
+	MountId mountArchive(const Path& file, Int32 priority = 0);
+
+	bool unmount(MountId id);
+	void clear();
+
+	std::vector<MountInfo> mounts() const;
+	Size mountCount() const;
+
+	Resolved resolve(const Path& path) const;
+	inline bool exists(const Path& path) const { return static_cast<bool>(resolve(path)); }
+
+	/* Merged children of a directory; subdirectories end with '/' */
+	ref<const Listing> list(const Path& directory = {}) const;
+
+	/* Highest priority mount on disk, where writes through the tree end up */
+	ref<const ResourceFolder> writeTarget() const;
+
+	void invalidate() const;
+
+	Size cachedPaths() const;
+
+	static String normalize(const Path& path);
+
+private:
+	void _invalidate() const;
+	const Listing& _listingOf(const Mount& mount, Symbol directory) const;
+};
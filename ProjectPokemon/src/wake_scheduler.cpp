@@ -0,0 +1,220 @@
+#include "wake_scheduler.h"
+
+WakeScheduler::~WakeScheduler()
+{
+	clear();
+}
+
+void WakeScheduler::sleep(UniqueId uid)
+{
+	_request({ Request::Kind::sleep, uid });
+}
+
+void WakeScheduler::sleepFor(UniqueId uid, const sf::Time& duration)
+{
+	_request({ Request::Kind::sleepFor, uid, std::max<Int64>(duration.asMicroseconds(), 0) });
+}
+
+void WakeScheduler::sleepUntilEvent(UniqueId uid, EventRouter& router, const EventFilter& filter)
+{
+	_request({ Request::Kind::sleepUntilEvent, uid, 0, &router, filter });
+}
+
+void WakeScheduler::sleepUntilNear(UniqueId uid, float radius)
+{
+	_request({ Request::Kind::sleepUntilNear, uid, 0, nullptr, {}, std::max(radius, 0.f) });
+}
+
+void WakeScheduler::wake(UniqueId uid)
+{
+	_request({ Request::Kind::wake, uid });
+}
+
+void WakeScheduler::_request(Request&& request)
+{
+	std::scoped_lock lock{ _requestMutex };
+	_requests.push_back(std::move(request));
+}
+
+void WakeScheduler::_apply(const Request& request)
+{
+	if (request.kind == Request::Kind::wake)
+	{
+		_wake(request.uid);
+		return;
+	}
+
+	Sleeper& sleeper = _sleeperOf(request.uid);
+	switch (request.kind)
+	{
+		case Request::Kind::sleepFor:
+			_timers.push_back({ _now + request.duration, request.uid, sleeper.sequence });
+			std::push_heap(_timers.begin(), _timers.end(), std::greater<Timer>());
+			break;
+
+		case Request::Kind::sleepUntilEvent:
+			if (sleeper.router)
+				sleeper.router->unsubscribe(sleeper.subscription);
+
+			sleeper.router = request.router;
+			sleeper.subscription = request.router->subscribe(request.filter, [this, uid = request.uid](const sf::Event&) {
+				_wake(uid);
+				return false;
+			});
+			break;
+
+		case Request::Kind::sleepUntilNear:
+			if (sleeper.radius <= 0)
+				++_nearCount;
+
+			sleeper.radius = request.radius;
+			_maxRadius = std::max(_maxRadius, sleeper.radius);
+			break;
+
+		default:
+			break;
+	}
+}
+
+bool WakeScheduler::_wake(UniqueId uid)
+{
+	auto it = _sleepers.find(uid);
+	if (it == _sleepers.end())
+		return false;
+
+	_forget(it->second);
+	_sleepers.erase(it);
+	_changes.emplace_back(uid, false);
+	return true;
+}
+
+void WakeScheduler::wakeNear(const SpatialGrid& index, const Vec2f& point)
+{
+	if (_nearCount == 0)
+		return;
+
+	std::vector<UniqueId> woken;
+	index.queryRadius(point, _maxRadius, [this, &index, &point, &woken](UniqueId uid) {
+		auto it = _sleepers.find(uid);
+		if (it == _sleepers.end() || it->second.radius <= 0)
+			return;
+
+		float radius = it->second.radius;
+		if (SpatialGrid::distanceSquared(point, *index.boundsOf(uid)) <= radius * radius)
+			woken.push_back(uid);
+	});
+
+	for (UniqueId uid : woken)
+		_wake(uid);
+}
+
+void WakeScheduler::addNearSource(UniqueId uid)
+{
+	if (uid && std::find(_sources.begin(), _sources.end(), uid) == _sources.end())
+		_sources.push_back(uid);
+}
+
+bool WakeScheduler::removeNearSource(UniqueId uid)
+{
+	return std::erase(_sources, uid) > 0;
+}
+
+void WakeScheduler::wakeNearSources(const SpatialGrid& index)
+{
+	if (_nearCount == 0)
+		return;
+
+	for (UniqueId uid : _sources)
+		if (const sf::FloatRect* bounds = index.boundsOf(uid))
+			wakeNear(index, { bounds->left + bounds->width / 2, bounds->top + bounds->height / 2 });
+}
+
+bool WakeScheduler::drop(UniqueId uid)
+{
+	removeNearSource(uid);
+
+	auto it = _sleepers.find(uid);
+	if (it == _sleepers.end())
+		return false;
+
+	_forget(it->second);
+	_sleepers.erase(it);
+	return true;
+}
+
+void WakeScheduler::advance(const sf::Time& delta, GameObjectRegistry& registry)
+{
+	{
+		std::scoped_lock lock{ _requestMutex };
+		_applying.swap(_requests);
+	}
+	for (const Request& request : _applying)
+		_apply(request);
+	_applying.clear();
+
+	_now += std::max<Int64>(delta.asMicroseconds(), 0);
+	while (!_timers.empty() && _timers.front().due <= _now)
+	{
+		std::pop_heap(_timers.begin(), _timers.end(), std::greater<Timer>());
+		Timer timer = _timers.back();
+		_timers.pop_back();
+
+		auto it = _sleepers.find(timer.uid);
+		if (it != _sleepers.end() && it->second.sequence == timer.sequence)
+			_wake(timer.uid);
+	}
+
+	for (const auto& change : _changes)
+	{
+		if (change.second)
+		{
+			if (!registry.sleepGameObject(change.first) && !registry.getGameObjectById(change.first))
+			{
+				auto it = _sleepers.find(change.first);
+				if (it != _sleepers.end())
+				{
+					_forget(it->second);
+					_sleepers.erase(it);
+				}
+			}
+		}
+		else registry.wakeGameObject(change.first);
+	}
+	_changes.clear();
+}
+
+void WakeScheduler::clear()
+{
+	for (auto& sleeper : _sleepers)
+		_forget(sleeper.second);
+
+	_sleepers.clear();
+	_timers.clear();
+	_changes.clear();
+	_sources.clear();
+
+	std::scoped_lock lock{ _requestMutex };
+	_requests.clear();
+}
+
+WakeScheduler::Sleeper& WakeScheduler::_sleeperOf(UniqueId uid)
+{
+	auto result = _sleepers.try_emplace(uid, Sleeper{ 0, {}, nullptr, 0 });
+	if (result.second)
+	{
+		result.first->second.sequence = ++_sequence;
+		_changes.emplace_back(uid, true);
+	}
+	return result.first->second;
+}
+
+void WakeScheduler::_forget(Sleeper& sleeper)
+{
+	if (sleeper.router)
+		sleeper.router->unsubscribe(sleeper.subscription);
+	sleeper.router = nullptr;
+
+	if (sleeper.radius > 0 && --_nearCount == 0)
+		_maxRadius = 0;
+	sleeper.radius = 0;
+}
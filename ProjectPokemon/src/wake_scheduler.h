@@ -0,0 +1,100 @@
+#pragma once
+
+#include "game_basics.h"
+#include "events.h"
+
+/*
+ * Puts game objects to sleep until a timer expires, a routed event arrives or
+ * a point of interest comes within a radius. Requests are queued behind a
+ * mutex and applied in advance(), outside of the update pass, so objects may
+ * ask to sleep or wake from their own update(), including on job workers.
+ * Everything else is main-thread only. Points of interest are either passed to wakeNear() or
+ * registered as near sources, whose bounds are looked up in the index by
+ * wakeNearSources().
+ */
+class WakeScheduler
+{
+private:
+	struct Sleeper
+	{
+		UInt32 sequence;
+		SlotHandle subscription;
+		EventRouter* router;
+		float radius;
+	};
+
+	struct Request
+	{
+		enum class Kind : UInt8 { sleep, sleepFor, sleepUntilEvent, sleepUntilNear, wake };
+
+		Kind kind;
+		UniqueId uid;
+		Int64 duration = 0;
+		EventRouter* router = nullptr;
+		EventFilter filter{};
+		float radius = 0;
+	};
+
+	struct Timer
+	{
+		Int64 due;
+		UniqueId uid;
+		UInt32 sequence;
+
+		inline bool operator> (const Timer& right) const { return due > right.due; }
+	};
+
+	FlatHashMap<UniqueId, Sleeper, UniqueId::hash> _sleepers;
+	std::vector<Timer> _timers;
+	std::vector<std::pair<UniqueId, bool>> _changes;
+	std::vector<UniqueId> _sources;
+	std::mutex _requestMutex;
+	std::vector<Request> _requests;
+	std::vector<Request> _applying;
+	Int64 _now = 0;
+	UInt32 _sequence = 0;
+	Size _nearCount = 0;
+	float _maxRadius = 0;
+
+public:
+	WakeScheduler() = default;
+	~WakeScheduler();
+
+	WakeScheduler(const WakeScheduler&) = delete;
+	WakeScheduler(WakeScheduler&&) = delete;
+
+	WakeScheduler& operator= (const WakeScheduler&) = delete;
+	WakeScheduler& operator= (WakeScheduler&&) = delete;
+
+public:
+	void sleep(UniqueId uid);
+	void sleepFor(UniqueId uid, const sf::Time& duration);
+	void sleepUntilEvent(UniqueId uid, EventRouter& router, const EventFilter& filter);
+	void sleepUntilNear(UniqueId uid, float radius);
+
+	void wake(UniqueId uid);
+	void wakeNear(const SpatialGrid& index, const Vec2f& point);
+
+	void addNearSource(UniqueId uid);
+	bool removeNearSource(UniqueId uid);
+	void wakeNearSources(const SpatialGrid& index);
+
+	/* Forgets a destroyed object, both as a sleeper and as a near source */
+	bool drop(UniqueId uid);
+
+	void advance(const sf::Time& delta, GameObjectRegistry& registry);
+	void clear();
+
+	inline bool isSleeping(UniqueId uid) const { return _sleepers.contains(uid); }
+	inline Size sleepingCount() const { return _sleepers.size(); }
+	inline Size nearSourceCount() const { return _sources.size(); }
+	inline sf::Time now() const { return sf::microseconds(_now); }
+
+private:
+	void _request(Request&& request);
+	void _apply(const Request& request);
+	bool _wake(UniqueId uid);
+
+	Sleeper& _sleeperOf(UniqueId uid);
+	void _forget(Sleeper& sleeper);
+};